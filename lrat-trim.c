@@ -25,7 +25,16 @@ static const char * usage =
 "  --no-check      disable checking clauses (default without CNF)\n"
 "  --no-trim       disable trimming (assume all clauses used)\n"
 "\n"
+"  --compact       store antecedents delta encoded in memory\n"
+"  --lazy          decode literals from mapped inputs only for the core\n"
+"  --memory=<MB>   spill clauses beyond '<MB>' MB to a temporary file\n"
+"  --framed[=<KB>] write binary proof in frames for parallel parsing\n"
+"                  of '<KB>' KB each (default '1024')\n"
+"\n"
 "  --relax         ignore deletion of clauses which were never added\n"
+#ifndef NTHREADS
+"  --threads=<n>   parse, trim and check with '<n>' threads (default '1')\n"
+#endif
 "\n"
 "and '<file> ...' is a non-empty list of at most four DIMACS and LRAT files:\n"
 "\n"
@@ -75,16 +84,29 @@ static const char * usage =
 "same specified file path except for '-' and '/dev/null'.  The latter is a\n"
 "hard-coded name and will not actually be opened nor written to '/dev/null'\n"
 "(whether it exists or not on the system).\n"
+"\n"
+"Input files compressed with 'gzip', 'bzip2', 'xz', 'lzma' or 'zstd' are\n"
+"detected by their magic bytes and decompressed on-the-fly by piping them\n"
+"through the corresponding external tool, which has to be installed.\n"
+"Output files with suffix '.gz', '.bz2', '.xz', '.lzma' or '.zst' are\n"
+"compressed on-the-fly in the same way.\n"
 
 ;
 
 // clang-format on
 
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
 #include <assert.h>
 #include <ctype.h>
+#include <inttypes.h>
 #include <limits.h>
+#include <setjmp.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -92,6 +114,8 @@ static const char * usage =
 struct file {
   const char *path;
   FILE *file;
+  unsigned char *map;
+  size_t size;
   size_t bytes;
   size_t lines;
   bool binary;
@@ -101,6 +125,32 @@ struct file {
   int saved;
 };
 
+// Clause identifiers are 'int' by default, which limits them to 'INT_MAX'.
+// Very long proofs might use more than 2^31 identifiers though and then
+// 'lrat-trim' has to be compiled with '-DLONGIDS' (use 'configure
+// --long-ids') to use 64-bit identifiers instead.  Literals remain 'int'.
+// To avoid doubling the memory needed for clauses the antecedents of
+// clauses are then always stored delta encoded in memory (as with
+// '--compact'), which for typical proofs needs less than 32 bits per
+// antecedent (see 'pack_antecedents').  The maps indexed by clause
+// identifiers need more memory though.
+
+#ifdef LONGIDS
+typedef int64_t clause_id;
+typedef uint64_t unsigned_clause_id;
+#define PRIid PRId64
+#define PRIuid PRIu64
+#define max_clause_id INT64_MAX
+#define max_clause_id_name "INT64_MAX"
+#else
+typedef int clause_id;
+typedef unsigned unsigned_clause_id;
+#define PRIid "d"
+#define PRIuid "u"
+#define max_clause_id INT_MAX
+#define max_clause_id_name "INT_MAX"
+#endif
+
 struct bool_stack {
   bool *begin, *end, *allocated;
 };
@@ -117,15 +167,41 @@ struct int_map {
   int *begin, *end;
 };
 
+struct unsigned_map {
+  unsigned *begin, *end;
+};
+
+struct id_stack {
+  clause_id *begin, *end, *allocated;
+};
+
+struct id_map {
+  clause_id *begin, *end;
+};
+
 struct ints_map {
   int **begin, **end;
 };
 
+struct ints_stack {
+  int **begin, **end, **allocated;
+};
+
 struct size_t_map {
   size_t *begin, *end;
 };
 
-struct statistics {
+// The state of the clause checker (assignment, marks, unpacked antecedents
+// and statistics) is thread local in order to check clauses
+// concurrently during backward checking (see 'check_clauses_in_parallel').
+
+#ifndef NTHREADS
+#define THREAD_LOCAL __thread
+#else
+#define THREAD_LOCAL
+#endif
+
+THREAD_LOCAL struct statistics {
   struct {
     struct {
       size_t added, deleted;
@@ -137,6 +213,7 @@ struct statistics {
       size_t empty;
     } checked;
     size_t resolved;
+    size_t vectorized;
   } clauses;
   struct {
     size_t assigned;
@@ -166,41 +243,52 @@ struct {
 } cnf, proof;
 
 static const char *ascii;
+static const char *compact;
 static const char *force;
 static const char *forward;
+static const char *framed;
+static const char *lazy;
+static const char *memory;
 static const char *nocheck;
 static const char *notrim;
 static const char *strict;
 static const char *track;
 static int verbosity;
 
+#ifndef NTHREADS
+static int threads = 1;
+#define max_threads 1024
+#endif
+
 static bool checking;
+static bool lazy_literals;
 static bool trimming;
 static bool relax;
 
-static int empty_clause;
-static int last_clause_added_in_cnf;
-static int first_clause_added_in_proof;
+static clause_id empty_clause;
+static clause_id last_clause_added_in_cnf;
+static clause_id first_clause_added_in_proof;
 
-static struct {
-  struct char_map marks;
-  struct char_map values;
+static THREAD_LOCAL struct {
+  struct unsigned_map marks;
+  struct unsigned_map values;
+  unsigned stamp;
   int original;
 } variables;
 
-static struct int_stack trail;
+static struct int_stack parsed_literals;
+static struct id_stack parsed_antecedents;
 
 static struct {
   struct char_map status;
   struct ints_map literals;
-  struct ints_map antecedents;
   struct size_t_map deleted;
   struct size_t_map added;
   struct int_map referenced;
-  struct int_map heads;
-  struct int_map links;
-  struct int_map used;
-  struct int_map map;
+  struct id_map heads;
+  struct id_map links;
+  struct id_map used;
+  struct id_map map;
 } clauses;
 
 static void die (const char *, ...) __attribute__ ((format (printf, 1, 2)));
@@ -209,6 +297,10 @@ static void msg (const char *, ...) __attribute__ ((format (printf, 1, 2)));
 static void vrb (const char *, ...) __attribute__ ((format (printf, 1, 2)));
 static void wrn (const char *, ...) __attribute__ ((format (printf, 1, 2)));
 
+#ifndef NTHREADS
+static void finish_pipeline ();
+#endif
+
 static void die (const char *fmt, ...) {
   fputs ("lrat-trim: error: ", stderr);
   va_list ap;
@@ -220,6 +312,9 @@ static void die (const char *fmt, ...) {
 }
 
 static void prr (const char *fmt, ...) {
+#ifndef NTHREADS
+  finish_pipeline ();
+#endif
   assert (input.path);
   if (input.binary) {
     fprintf (stderr,
@@ -409,6 +504,60 @@ static void *coverage_realloc (size_t line, void *p, size_t bytes) {
 
 #define RELEASE(STACK) free ((STACK).begin)
 
+// Maps indexed by variables or clause identifiers are resized by 'ADJUST'
+// which zero initializes new entries.  Clause identifiers might be sparse,
+// for instance if a distributed solver hands out identifier ranges to its
+// workers.  In order to avoid paying memory for the whole identifier range
+// instead of the actual number of clauses, large maps are allocated as
+// anonymous memory mappings, which are zero initialized lazily by the
+// operating system.  Then only pages of the map which are actually written
+// become resident and the page table of the operating system serves as a
+// sparse index for large identifier gaps.  On Linux these mappings are
+// grown with 'mremap' without copying and thus without touching the gaps.
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define min_mapped_bytes ((size_t)1 << 20)
+
+static void *resize_map (void *old_begin, size_t old_bytes,
+                         size_t new_bytes) {
+  assert (old_bytes < new_bytes);
+  void *res;
+  if (new_bytes < min_mapped_bytes) {
+    if (!old_bytes)
+      return calloc (1, new_bytes);
+    if ((res = realloc (old_begin, new_bytes)))
+      memset ((char *)res + old_bytes, 0, new_bytes - old_bytes);
+    return res;
+  }
+#ifdef MREMAP_MAYMOVE
+  if (old_bytes >= min_mapped_bytes) {
+    res = mremap (old_begin, old_bytes, new_bytes, MREMAP_MAYMOVE);
+    return res == MAP_FAILED ? 0 : res;
+  }
+#endif
+  res = mmap (0, new_bytes, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (res == MAP_FAILED)
+    return 0;
+  if (old_bytes) {
+    memcpy (res, old_begin, old_bytes);
+    if (old_bytes >= min_mapped_bytes)
+      munmap (old_begin, old_bytes);
+    else
+      free (old_begin);
+  }
+  return res;
+}
+
+static void release_map (void *begin, size_t bytes) {
+  if (bytes >= min_mapped_bytes)
+    munmap (begin, bytes);
+  else
+    free (begin);
+}
+
 #define ADJUST(MAP, N) \
   do { \
     size_t NEEDED_SIZE = (size_t)(N) + 1; \
@@ -416,38 +565,359 @@ static void *coverage_realloc (size_t line, void *p, size_t bytes) {
     if (OLD_SIZE >= NEEDED_SIZE) \
       break; \
     size_t NEW_SIZE = OLD_SIZE ? 2 * OLD_SIZE : 1; \
-    void *OLD_BEGIN = (MAP).begin; \
-    void *NEW_BEGIN; \
     while (NEW_SIZE < NEEDED_SIZE) \
       NEW_SIZE *= 2; \
-    if (OLD_SIZE) { \
-      size_t NEW_BYTES = NEW_SIZE * sizeof *(MAP).begin; \
-      assert (OLD_BEGIN); \
-      NEW_BEGIN = realloc (OLD_BEGIN, NEW_BYTES); \
-      if (!NEW_BEGIN) \
+    size_t OLD_BYTES = OLD_SIZE * sizeof *(MAP).begin; \
+    size_t NEW_BYTES = NEW_SIZE * sizeof *(MAP).begin; \
+    void *NEW_BEGIN = resize_map ((MAP).begin, OLD_BYTES, NEW_BYTES); \
+    if (!NEW_BEGIN) { \
+      if (OLD_SIZE) \
         die ("out-of-memory resizing '" #MAP "' map"); \
-      size_t OLD_BYTES = OLD_SIZE * sizeof *(MAP).begin; \
-      size_t DELTA_BYTES = NEW_BYTES - OLD_BYTES; \
-      memset ((char *)NEW_BEGIN + OLD_BYTES, 0, DELTA_BYTES); \
-    } else { \
-      assert (!OLD_BEGIN); \
-      NEW_BEGIN = calloc (NEW_SIZE, sizeof *(MAP).begin); \
-      if (!NEW_BEGIN) \
+      else \
         die ("out-of-memory initializing '" #MAP "' map"); \
     } \
     (MAP).begin = NEW_BEGIN; \
     (MAP).end = (MAP).begin + NEW_SIZE; \
   } while (0)
 
+#define RELEASE_MAP(MAP) \
+  release_map ((MAP).begin, SIZE (MAP) * sizeof *(MAP).begin)
+
+// Clauses are allocated from an arena of large chunks instead of calling
+// 'malloc' for each clause separately.  This avoids the header and rounding
+// overhead of 'malloc' for billions of small arrays and is also faster.
+// Chunks are only released as a whole at the end.  Sizes are rounded up to
+// an even number of integers such that freed arrays can hold a pointer to
+// the next freed array of the same size.  These free lists recycle clauses
+// deleted eagerly (see 'delete_antecedent').  Large arrays are still
+// allocated with 'malloc' and freed directly, which is decided by the size
+// passed to 'free_ints', which thus has to match the allocated size.
+
+#define size_arena_chunk ((size_t)1 << 20)
+#define max_arena_size ((size_t)1 << 10)
+
+static struct {
+  int *pos, *end;
+  int *free[max_arena_size / 2 + 1];
+  struct ints_stack chunks;
+  struct ints_stack spilled;
+  bool unordered;
+  clause_id last;
+  size_t literals, antecedents;
+} arena;
+
+// With '--memory=<MB>' arena chunks are only allocated in main memory until
+// their total size reaches the given limit.  Further chunks are mapped
+// from a temporary file instead, which is created in the directory given
+// by the environment variable 'TMPDIR' (defaulting to '/tmp') and unlinked
+// immediately.  Clauses in these chunks are accessed through the same
+// pointers as clauses in memory and the operating system writes them back
+// to the file and evicts them from memory when it runs short of it.  Thus
+// the page cache acts as least-recently-used cache for spilled clauses
+// during trimming and writing.  The last filled chunk is further dropped
+// from the resident memory of the process explicitly.
+
+static size_t memory_limit;
+
+static struct {
+  int fd;
+  char *path;
+  size_t chunks, total;
+} spill;
+
+static int *spill_chunk () {
+  size_t bytes = size_arena_chunk * sizeof (int);
+  if (!spill.path) {
+    const char *dir = getenv ("TMPDIR");
+    if (!dir)
+      dir = "/tmp";
+    size_t len = strlen (dir) + 32;
+    if (!(spill.path = malloc (len)))
+      die ("out-of-memory allocating temporary file name");
+    snprintf (spill.path, len, "%s/lrat-trim-XXXXXX", dir);
+    if ((spill.fd = mkstemp (spill.path)) < 0)
+      die ("can not create temporary file '%s' to spill clauses",
+           spill.path);
+    unlink (spill.path);
+    vrb ("spilling clauses to temporary file '%s'", spill.path);
+  }
+  size_t offset = spill.chunks * bytes;
+  if (ftruncate (spill.fd, offset + bytes))
+    die ("can not extend temporary file '%s' to %zu bytes", spill.path,
+         offset + bytes);
+  void *chunk = mmap (0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      spill.fd, offset);
+  if (chunk == MAP_FAILED)
+    die ("can not map %zu bytes of temporary file '%s' at offset %zu",
+         bytes, spill.path, offset);
+  if (!EMPTY (arena.spilled))
+    (void)madvise (arena.spilled.end[-1], bytes, MADV_DONTNEED);
+  PUSH (arena.spilled, chunk);
+  spill.chunks++;
+  spill.total++;
+  return chunk;
+}
+
+static int *allocate_ints (size_t size) {
+  assert (size);
+  if (size > max_arena_size)
+    return malloc (size * sizeof (int));
+  size_t rounded = (size + 1) & ~(size_t)1;
+  int **free_list = arena.free + rounded / 2;
+  int *res = *free_list;
+  if (res) {
+    memcpy (free_list, res, sizeof *free_list);
+    arena.unordered = true;
+    return res;
+  }
+  if ((size_t)(arena.end - arena.pos) < rounded) {
+    int *chunk;
+    size_t bytes = SIZE (arena.chunks) * size_arena_chunk * sizeof (int);
+    if (memory && bytes >= memory_limit)
+      chunk = spill_chunk ();
+    else if ((chunk = malloc (size_arena_chunk * sizeof (int))))
+      PUSH (arena.chunks, chunk);
+    else
+      return 0;
+    arena.pos = chunk;
+    arena.end = chunk + size_arena_chunk;
+  }
+  res = arena.pos;
+  arena.pos += rounded;
+  return res;
+}
+
+static void free_ints (int *ints, size_t size) {
+  assert (size);
+  if (size > max_arena_size) {
+    free (ints);
+    return;
+  }
+  size_t rounded = (size + 1) & ~(size_t)1;
+  int **free_list = arena.free + rounded / 2;
+  memcpy (ints, free_list, sizeof *free_list);
+  *free_list = ints;
+}
+
+// Each clause is stored as a single record in the arena, which consists of
+// a header holding the number of literals including the terminating zero,
+// followed by the zero terminated literals and then the zero terminated
+// antecedents of the clause.  The antecedents are empty for original
+// clauses and if they are not needed (for instance while forward checking).
+// Clauses are referenced by a pointer to their literals in 'clauses.literals'
+// and the antecedents directly follow the literals.  Thus checking, trimming
+// and writing clauses accesses only one pointer and consecutive memory.
+
+// With '--compact' antecedents are stored as zero terminated sequence of
+// bytes instead of integers, using the same variable length encoding as
+// binary proofs for the difference of the clause and the antecedent
+// identifier shifted by one with the sign of the antecedent in the lowest
+// bit.  As antecedents usually refer to recently added clauses this mostly
+// needs one or two bytes per antecedent instead of four.  The first byte of
+// each encoded antecedent is non-zero as differences are positive and the
+// last byte is non-zero too, thus the first zero byte terminates the list.
+// Before use they are decoded into 'unpacked' (see 'unpack_antecedents').
+// With 64-bit identifiers antecedents are always stored in this way.
+
+static THREAD_LOCAL struct id_stack unpacked;
+
+#ifdef LONGIDS
+#define packed_antecedents true
+#else
+#define packed_antecedents (compact != 0)
+#endif
+
+static inline int *clause_antecedents (int *literals) {
+  return literals + literals[-1];
+}
+
+static inline unsigned_clause_id pack_antecedent (clause_id id,
+                                                  clause_id other) {
+  assert (other);
+  clause_id abs_other = other < 0 ? -other : other;
+  assert (abs_other < id);
+  unsigned_clause_id delta = id - abs_other;
+  return 2 * delta + (other < 0);
+}
+
+static size_t packed_bytes (clause_id id, clause_id *antecedents) {
+  size_t bytes = 1;
+  for (clause_id *p = antecedents, other; (other = *p); p++)
+    for (unsigned_clause_id u = pack_antecedent (id, other); u; u >>= 7)
+      bytes++;
+  return bytes;
+}
+
+static void pack_antecedents (clause_id id, clause_id *antecedents,
+                              unsigned char *p) {
+  for (clause_id *q = antecedents, other; (other = *q); q++) {
+    unsigned_clause_id u = pack_antecedent (id, other);
+    while (u > 127) {
+      *p++ = (u & 127) | 128;
+      u >>= 7;
+    }
+    *p++ = u;
+  }
+  *p = 0;
+}
+
+static clause_id *unpack_antecedents (clause_id id, int *literals) {
+  int *a = clause_antecedents (literals);
+#ifndef LONGIDS
+  if (!compact)
+    return a;
+#endif
+  CLEAR (unpacked);
+  for (const unsigned char *p = (unsigned char *)a; *p;) {
+    unsigned_clause_id u = 0, ch;
+    unsigned shift = 0;
+    do {
+      ch = *p++;
+      u |= (ch & 127) << shift;
+      shift += 7;
+    } while (ch & 128);
+    clause_id other = id - (clause_id)(u >> 1);
+    PUSH (unpacked, (u & 1) ? -other : other);
+  }
+  PUSH (unpacked, 0);
+  return unpacked.begin;
+}
+
+static size_t clause_size (int *literals) {
+  int *a = clause_antecedents (literals);
+  size_t size = 1 + literals[-1];
+  if (packed_antecedents) {
+    const unsigned char *p = (unsigned char *)a;
+    while (*p++)
+      ;
+    size_t bytes = p - (unsigned char *)a;
+    return size + (bytes + sizeof (int) - 1) / sizeof (int);
+  }
+  const int *p = a;
+  while (*p++)
+    ;
+  return size + (p - a);
+}
+
+static int *new_clause (clause_id id, int *literals, size_t size_literals,
+                        clause_id *antecedents, size_t size_antecedents) {
+  assert (size_literals);
+  assert (size_literals <= INT_MAX);
+  size_t size = 1 + size_literals;
+  if (!size_antecedents)
+    size++;
+  else if (packed_antecedents) {
+    size_t bytes = packed_bytes (id, antecedents);
+    size += (bytes + sizeof (int) - 1) / sizeof (int);
+  } else
+    size += size_antecedents;
+  int *c = allocate_ints (size);
+  if (!c)
+    die ("out-of-memory allocating clause %" PRIid " "
+         "with %zu literals and %zu antecedents",
+         id, size_literals - 1, size_antecedents ? size_antecedents - 1 : 0);
+  arena.literals += (1 + size_literals) * sizeof (int);
+  arena.antecedents += (size - 1 - size_literals) * sizeof (int);
+  int *l = c + 1, *a = l + size_literals;
+  l[-1] = size_literals;
+  memcpy (l, literals, size_literals * sizeof (int));
+  if (!size_antecedents)
+    *a = 0;
+  else if (packed_antecedents)
+    pack_antecedents (id, antecedents, (unsigned char *)a);
+  else
+    memcpy (a, antecedents, size_antecedents * sizeof (int));
+  ADJUST (clauses.literals, id);
+  ACCESS (clauses.literals, id) = l;
+  if (id <= arena.last)
+    arena.unordered = true;
+  arena.last = id;
+  return l;
+}
+
+static size_t forget_clause (int *literals) {
+  size_t size = clause_size (literals);
+  size_t size_literals = 1 + literals[-1];
+  arena.literals -= size_literals * sizeof (int);
+  arena.antecedents -= (size - size_literals) * sizeof (int);
+  return size;
+}
+
+static void delete_clause (int *literals) {
+  free_ints (literals - 1, forget_clause (literals));
+}
+
+// With '--lazy' the literals of clauses are not copied while parsing
+// mapped input files.  Instead the record holds the offset of the first
+// literal of the clause in the mapped file in place of its literals.  The
+// header still gives the size of this place holder and thus antecedents
+// are found in the same way as for other records.  After trimming the
+// literals of core clauses are decoded again from the mapped input files
+// (see 'materialize_clauses'), which makes the memory needed for literals
+// proportional to the size of the core instead of the whole proof.
+
+#define lazy_offset_ints (sizeof (size_t) / sizeof (int))
+
+static void new_lazy_clause (clause_id id, size_t offset,
+                             clause_id *antecedents,
+                             size_t size_antecedents) {
+  int ints[lazy_offset_ints];
+  memcpy (ints, &offset, sizeof offset);
+  new_clause (id, ints, lazy_offset_ints, antecedents, size_antecedents);
+}
+
+static size_t lazy_offset (int *literals) {
+  assert (literals[-1] == lazy_offset_ints);
+  size_t offset;
+  memcpy (&offset, literals, sizeof offset);
+  return offset;
+}
+
+// Only original clauses in the CNF and clauses added in the proof have
+// records.  Scans over all records skip the identifiers in between, which
+// without CNF are all identifiers below the first added clause, since
+// proofs might start at large offsets.  These scans also end at the last
+// clause with a record instead of at the end of the map.
+
+static size_t next_record (size_t id) {
+  id++;
+  if (id > (size_t)last_clause_added_in_cnf &&
+      id < (size_t)first_clause_added_in_proof)
+    id = first_clause_added_in_proof;
+  return id;
+}
+
+static size_t end_of_records () {
+  assert (!arena.last || (size_t)arena.last < SIZE (clauses.literals));
+  return (size_t)arena.last + 1;
+}
+
 #ifndef NDEBUG
 
-static void release_ints_map (struct ints_map *map) {
-  int **begin = map->begin;
-  int **end = map->end;
-  for (int **p = begin; p != end; p++)
-    if (*p)
-      free (*p);
-  free (begin);
+static void release_clauses () {
+  int **literals = clauses.literals.begin;
+  size_t size_literals = end_of_records ();
+  for (size_t id = next_record (0); id < size_literals;
+       id = next_record (id)) {
+    int *l = literals[id];
+    if (l && clause_size (l) > max_arena_size)
+      free (l - 1);
+  }
+  RELEASE_MAP (clauses.literals);
+}
+
+static void release_arena () {
+  for (int **p = arena.chunks.begin; p != arena.chunks.end; p++)
+    free (*p);
+  RELEASE (arena.chunks);
+  size_t bytes = size_arena_chunk * sizeof (int);
+  for (int **p = arena.spilled.begin; p != arena.spilled.end; p++)
+    munmap (*p, bytes);
+  RELEASE (arena.spilled);
+  if (spill.path) {
+    close (spill.fd);
+    free (spill.path);
+  }
 }
 
 #endif
@@ -493,6 +963,17 @@ static void logging_suffix () {
     logging_suffix (); \
   } while (0)
 
+#define dbgids(IDS, ...) \
+  do { \
+    if (!logging ()) \
+      break; \
+    logging_prefix (__VA_ARGS__); \
+    const clause_id *P = (IDS); \
+    while (*P) \
+      printf (" %" PRIid, *P++); \
+    logging_suffix (); \
+  } while (0)
+
 #else
 
 #define dbg(...) \
@@ -503,26 +984,225 @@ static void logging_suffix () {
   do { \
   } while (0)
 
+#define dbgids(...) \
+  do { \
+  } while (0)
+
 #endif
 
 // Having a statically allocated read buffer allows to inline more character
 // reading code into integer parsing routines and thus speed up overall
 // parsing time substantially (saw 30% improvement).
 
+// For memory mapped input files (see 'map_file' below) the buffer simply
+// points to the mapping and thus the parser scans the file directly without
+// copying it.  Otherwise it points to the statically allocated characters.
+
 #define size_buffer (1u << 20)
 
+static unsigned char buffer_chars[size_buffer];
+
 struct buffer {
-  unsigned char chars[size_buffer];
+  unsigned char *chars;
   size_t pos, end;
-} buffer;
+} buffer = {buffer_chars, 0, 0};
+
+#ifndef NTHREADS
+
+#include <pthread.h>
+
+// Unless the input file is mapped, reading through 'fread' blocks the
+// parser whenever the buffer runs empty, for instance when the proof is
+// piped from the SAT solver.  Therefore a background thread reads ahead
+// into a ring of large buffers, while the parser consumes the previously
+// filled buffer.  The parser holds on to one buffer at a time and only
+// releases it when asking for the next (in 'read_ahead_buffer').
+
+#define size_ahead_buffer (1u << 22)
+#define num_ahead_buffers 4
+
+static struct {
+  unsigned char *chars[num_ahead_buffers];
+  size_t size[num_ahead_buffers];
+  size_t produced, consumed;
+  bool active, holding, done;
+  pthread_mutex_t lock;
+  pthread_cond_t filled, released;
+  pthread_t thread;
+  FILE *file;
+} ahead = {.lock = PTHREAD_MUTEX_INITIALIZER,
+           .filled = PTHREAD_COND_INITIALIZER,
+           .released = PTHREAD_COND_INITIALIZER};
+
+static void *read_ahead (void *dummy) {
+  (void)dummy;
+  FILE *file = ahead.file;
+  size_t bytes;
+  do {
+    pthread_mutex_lock (&ahead.lock);
+    while (ahead.produced - ahead.consumed == num_ahead_buffers)
+      pthread_cond_wait (&ahead.released, &ahead.lock);
+    size_t i = ahead.produced % num_ahead_buffers;
+    pthread_mutex_unlock (&ahead.lock);
+    bytes = fread (ahead.chars[i], 1, size_ahead_buffer, file);
+    pthread_mutex_lock (&ahead.lock);
+    if (bytes) {
+      ahead.size[i] = bytes;
+      ahead.produced++;
+    } else
+      ahead.done = true;
+    pthread_cond_signal (&ahead.filled);
+    pthread_mutex_unlock (&ahead.lock);
+  } while (bytes);
+  return 0;
+}
+
+static void start_reading_ahead () {
+  assert (input.file);
+  assert (!input.map);
+  assert (!ahead.active);
+  if (!ahead.chars[0])
+    for (size_t i = 0; i != num_ahead_buffers; i++)
+      if (!(ahead.chars[i] = malloc (size_ahead_buffer)))
+        die ("out-of-memory allocating read-ahead buffers");
+  ahead.file = input.file;
+  ahead.produced = ahead.consumed = 0;
+  ahead.holding = ahead.done = false;
+  if (pthread_create (&ahead.thread, 0, read_ahead, 0))
+    die ("failed to start read-ahead thread for '%s'", input.path);
+  ahead.active = true;
+}
+
+static void stop_reading_ahead () {
+  assert (ahead.active);
+  if (pthread_join (ahead.thread, 0))
+    die ("failed to join read-ahead thread for '%s'", input.path);
+  assert (ahead.done);
+  ahead.active = false;
+}
+
+static size_t read_ahead_buffer () {
+  pthread_mutex_lock (&ahead.lock);
+  if (ahead.holding) {
+    ahead.consumed++;
+    ahead.holding = false;
+    pthread_cond_signal (&ahead.released);
+  }
+  while (ahead.produced == ahead.consumed && !ahead.done)
+    pthread_cond_wait (&ahead.filled, &ahead.lock);
+  size_t bytes = 0;
+  if (ahead.produced != ahead.consumed) {
+    size_t i = ahead.consumed % num_ahead_buffers;
+    buffer.chars = ahead.chars[i];
+    bytes = ahead.size[i];
+    ahead.holding = true;
+  }
+  pthread_mutex_unlock (&ahead.lock);
+  buffer.pos = 0;
+  buffer.end = bytes;
+  return bytes;
+}
+
+#endif
 
 static size_t fill_buffer () {
   assert (input.file);
+  if (input.map) {
+    if (buffer.chars == input.map)
+      return 0;
+    // Start at the current file position since 'open_input_files' might
+    // have already read the first characters through 'getc'.
+    off_t offset = ftello (input.file);
+    assert (offset >= 0);
+    buffer.chars = input.map;
+    buffer.pos = offset;
+    buffer.end = input.size;
+    return buffer.end - buffer.pos;
+  }
+#ifndef NTHREADS
+  if (ahead.active)
+    return read_ahead_buffer ();
+#endif
+  buffer.chars = buffer_chars;
   buffer.pos = 0;
   buffer.end = fread (buffer.chars, 1, size_buffer, input.file);
   return buffer.end;
 }
 
+#include <sys/stat.h>
+
+// Regular input files are mapped into memory and then scanned directly by
+// the parser (see 'fill_buffer') which saves copying the whole file through
+// 'fread'.  If mapping is not possible, for instance for pipes or empty
+// files, we silently fall back to buffered reading.
+
+static void map_file (struct file *file) {
+  assert (file->file);
+  assert (!file->map);
+  struct stat buf;
+  int fd = fileno (file->file);
+  if (fstat (fd, &buf) || !S_ISREG (buf.st_mode) || buf.st_size <= 0)
+    return;
+  size_t size = buf.st_size;
+  if ((off_t)size != buf.st_size)
+    return;
+  void *map = mmap (0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED)
+    return;
+  (void)madvise (map, size, MADV_SEQUENTIAL);
+  file->map = map;
+  file->size = size;
+}
+
+static void detach_buffer (struct file *file) {
+  assert (file->map);
+  if (buffer.chars == file->map) {
+    buffer.chars = buffer_chars;
+    buffer.pos = buffer.end = 0;
+  }
+}
+
+static void unmap_file (struct file *file) {
+  detach_buffer (file);
+  munmap (file->map, file->size);
+  file->map = 0;
+}
+
+// Called at the start and end of parsing an input file.
+
+static void start_reading () {
+  if (!input.file)
+    return;
+  if (input.map)
+    vrb ("mapped %s of '%s' into memory", pretty_bytes (input.size),
+         input.path);
+#ifndef NTHREADS
+  else {
+    start_reading_ahead ();
+    vrb ("reading '%s' ahead in background thread", input.path);
+  }
+#endif
+}
+
+static void stop_reading () {
+  if (!input.file)
+    return;
+#ifndef NTHREADS
+  if (ahead.active)
+    stop_reading_ahead ();
+#endif
+  if (input.map) {
+    if (lazy_literals)
+      detach_buffer (&input); // Still needed in 'materialize_clauses'.
+    else
+      unmap_file (&input);
+  }
+  if (input.close == 1)
+    fclose (input.file);
+  else if (input.close == 2 && pclose (input.file))
+    die ("decompressing '%s' failed", input.path);
+}
+
 // These three functions were not inlined with gcc-11 but should be despite
 // having declared them as 'inline' and thus we use this 'always_inline'
 // attribute which seems to succeed to force inlining.  Havin them inlined
@@ -587,7 +1267,7 @@ static inline void read_until_new_line (void) {
       prr ("unexpected end-of-file before new-line");
     input.bytes++;
     if (ch == '\r') {
-      ch = getc (input.file);
+      ch = read_buffer ();
       if (ch != EOF)
         input.bytes++;
       if (ch == '\n')
@@ -638,26 +1318,169 @@ static int read_first_char (void) {
   return res;
 }
 
-static void flush_buffer () {
-  size_t bytes = buffer.pos;
-  if (!bytes)
-    return;
-  if (!output.file) {
-    buffer.pos = 0;
-    return;
-  }
-  size_t written = fwrite (buffer.chars, 1, bytes, output.file);
+// The output has its own buffer.  With thread support it is one of a ring
+// of buffers which are handed over to a background writer thread when full.
+// Thus formatting the proof continues while earlier blocks are written,
+// which in essence is the reverse of reading ahead.
+
+#define size_write_buffer (1u << 22)
+
+static unsigned char write_buffer_chars[size_write_buffer];
+
+static struct buffer write_buffer = {write_buffer_chars, 0,
+                                     size_write_buffer};
+
+static void write_chars (FILE *file, const char *path,
+                         const unsigned char *chars, size_t bytes) {
+  size_t written = fwrite (chars, 1, bytes, file);
   bool failed = (written != bytes);
 #ifdef COVERAGE
   if (getenv ("LRAT_TRIM_FAKE_FRWRITE_FAILURE"))
     failed = true;
 #endif
   if (failed) {
-    assert (output.path);
-    die ("flushing %zu bytes of write-buffer to '%s' failed", bytes,
-         output.path);
+    assert (path);
+    die ("flushing %zu bytes of write-buffer to '%s' failed", bytes, path);
   }
-  buffer.pos = 0;
+}
+
+#ifndef NTHREADS
+
+#define num_behind_buffers 4
+
+static struct {
+  unsigned char *chars[num_behind_buffers];
+  size_t size[num_behind_buffers];
+  size_t produced, consumed;
+  bool active, done;
+  pthread_mutex_t lock;
+  pthread_cond_t filled, released;
+  pthread_t thread;
+  const char *path;
+  FILE *file;
+} behind = {.lock = PTHREAD_MUTEX_INITIALIZER,
+            .filled = PTHREAD_COND_INITIALIZER,
+            .released = PTHREAD_COND_INITIALIZER};
+
+static void *write_behind (void *dummy) {
+  (void)dummy;
+  for (;;) {
+    pthread_mutex_lock (&behind.lock);
+    while (behind.produced == behind.consumed && !behind.done)
+      pthread_cond_wait (&behind.filled, &behind.lock);
+    if (behind.produced == behind.consumed) {
+      pthread_mutex_unlock (&behind.lock);
+      break;
+    }
+    size_t i = behind.consumed % num_behind_buffers;
+    pthread_mutex_unlock (&behind.lock);
+    write_chars (behind.file, behind.path, behind.chars[i],
+                 behind.size[i]);
+    pthread_mutex_lock (&behind.lock);
+    behind.consumed++;
+    pthread_cond_signal (&behind.released);
+    pthread_mutex_unlock (&behind.lock);
+  }
+  return 0;
+}
+
+static void start_writing_behind () {
+  assert (output.file);
+  assert (!behind.active);
+  if (!behind.chars[0]) {
+    behind.chars[0] = write_buffer_chars;
+    for (size_t i = 1; i != num_behind_buffers; i++)
+      if (!(behind.chars[i] = malloc (size_write_buffer)))
+        die ("out-of-memory allocating write-behind buffers");
+  }
+  behind.file = output.file;
+  behind.path = output.path;
+  behind.produced = behind.consumed = 0;
+  behind.done = false;
+  write_buffer.chars = behind.chars[0];
+  if (pthread_create (&behind.thread, 0, write_behind, 0))
+    die ("failed to start writer thread for '%s'", output.path);
+  behind.active = true;
+}
+
+static void write_behind_buffer () {
+  pthread_mutex_lock (&behind.lock);
+  size_t i = behind.produced % num_behind_buffers;
+  assert (write_buffer.chars == behind.chars[i]);
+  behind.size[i] = write_buffer.pos;
+  behind.produced++;
+  pthread_cond_signal (&behind.filled);
+  while (behind.produced - behind.consumed == num_behind_buffers)
+    pthread_cond_wait (&behind.released, &behind.lock);
+  i = behind.produced % num_behind_buffers;
+  pthread_mutex_unlock (&behind.lock);
+  write_buffer.chars = behind.chars[i];
+  write_buffer.pos = 0;
+}
+
+static void stop_writing_behind () {
+  assert (behind.active);
+  pthread_mutex_lock (&behind.lock);
+  behind.done = true;
+  pthread_cond_signal (&behind.filled);
+  pthread_mutex_unlock (&behind.lock);
+  if (pthread_join (behind.thread, 0))
+    die ("failed to join writer thread for '%s'", output.path);
+  assert (behind.produced == behind.consumed);
+  write_buffer.chars = write_buffer_chars;
+  behind.active = false;
+}
+
+#endif
+
+// While writing a frame of a framed binary proof the write buffer points to
+// a separate frame buffer, which is enlarged instead of flushed if full, as
+// the frame header with the size of the frame has to be written first (see
+// 'write_frame' below).  The frame size can be set with '--framed=<KB>',
+// which is mostly useful for testing parallel parsing of frames.
+
+static size_t size_frame = (size_t)1 << 20;
+
+static struct {
+  unsigned char *chars;
+  size_t size;
+  unsigned clauses;
+  clause_id first;
+  bool active;
+  struct buffer saved;
+} framing;
+
+static void enlarge_frame () {
+  assert (framing.active);
+  assert (write_buffer.chars == framing.chars);
+  size_t size = 2 * framing.size;
+  unsigned char *chars = realloc (framing.chars, size);
+  if (!chars)
+    die ("out-of-memory enlarging frame buffer");
+  write_buffer.chars = framing.chars = chars;
+  write_buffer.end = framing.size = size;
+}
+
+static void flush_buffer () {
+  if (framing.active) {
+    enlarge_frame ();
+    return;
+  }
+  size_t bytes = write_buffer.pos;
+  if (!bytes)
+    return;
+  if (!output.file) {
+    write_buffer.pos = 0;
+    return;
+  }
+#ifndef NTHREADS
+  if (behind.active) {
+    write_behind_buffer ();
+    return;
+  }
+#endif
+  write_chars (output.file, output.path, write_buffer.chars, bytes);
+  write_buffer.pos = 0;
 }
 
 static inline void write_binary (unsigned char)
@@ -669,9 +1492,9 @@ static inline void write_unsigned (unsigned)
 static inline void write_signed (int) __attribute__ ((always_inline));
 
 static inline void write_binary (unsigned char ch) {
-  if (buffer.pos == size_buffer)
+  if (write_buffer.pos == write_buffer.end)
     flush_buffer ();
-  buffer.chars[buffer.pos++] = ch;
+  write_buffer.chars[write_buffer.pos++] = ch;
   output.bytes++;
 }
 
@@ -688,13 +1511,39 @@ static inline void write_signed (int i) {
   write_unsigned ((i < 0) + 2 * (unsigned)abs (i));
 }
 
+// Clause identifiers are written with these functions, which for 64-bit
+// identifiers (see 'clause_id') need their own versions.
+
+#ifdef LONGIDS
+
+static inline void write_unsigned_id (unsigned_clause_id u) {
+  while (u > 127) {
+    write_binary (128 | (u & 127));
+    u >>= 7;
+  }
+  write_binary (u);
+}
+
+static inline void write_signed_id (clause_id id) {
+  assert (id != INT64_MIN);
+  unsigned_clause_id abs_id = id < 0 ? -id : id;
+  write_unsigned_id ((id < 0) + 2 * abs_id);
+}
+
+#else
+
+#define write_unsigned_id write_unsigned
+#define write_signed_id write_signed
+
+#endif
+
 static inline void write_ascii (unsigned char)
     __attribute__ ((always_inline));
 
 static inline void write_ascii (unsigned char ch) {
-  if (buffer.pos == size_buffer)
+  if (write_buffer.pos == write_buffer.end)
     flush_buffer ();
-  buffer.chars[buffer.pos++] = ch;
+  write_buffer.chars[write_buffer.pos++] = ch;
   output.bytes++;
   if (ch == '\n')
     output.lines++;
@@ -728,6 +1577,33 @@ static inline void write_int (int i) {
     write_ascii ('0');
 }
 
+#ifdef LONGIDS
+
+static char id_buffer[24];
+
+static inline void write_id (clause_id id) {
+  if (id) {
+    char *p = id_buffer + sizeof id_buffer - 1;
+    assert (!*p);
+    assert (id != INT64_MIN);
+    unsigned_clause_id tmp = id < 0 ? -id : id;
+    while (tmp) {
+      *--p = '0' + (tmp % 10);
+      tmp /= 10;
+    }
+    if (id < 0)
+      *--p = '-';
+    write_str (p);
+  } else
+    write_ascii ('0');
+}
+
+#else
+
+#define write_id write_int
+
+#endif
+
 static char size_t_buffer[32];
 
 static inline void write_size_t (size_t i) {
@@ -746,7 +1622,6 @@ static inline void write_size_t (size_t i) {
 
 #include <sys/resource.h>
 #include <sys/time.h>
-#include <unistd.h>
 
 static double process_time () {
   struct rusage u;
@@ -767,64 +1642,200 @@ static double mega_bytes (void) {
   return maximum_resident_set_size () / (double)(1 << 20);
 }
 
-static double average (double a, double b) { return b ? a / b : 0; }
-static double percent (double a, double b) { return average (100 * a, b); }
+// Memory used by the main data structures is determined from their sizes,
+// except for literals and antecedents of clause records, which are counted
+// while allocating and deleting clauses (see 'new_clause').  These numbers
+// are printed in verbose mode after each phase in order to see which data
+// structure determines maximum memory usage.  Note that for large maps only
+// actually written pages are resident (see 'resize_map').
 
-static inline void assign_literal (int lit) {
-  assert (lit);
-  assert (lit != INT_MIN);
-  dbg ("assigning literal %d", lit);
-  int idx = abs (lit);
-  signed char value = lit < 0 ? -1 : 1;
-  signed char *v = &ACCESS (variables.values, idx);
-  assert (!*v);
-  *v = value;
-  PUSH (trail, lit);
-  statistics.literals.assigned++;
+#define MAP_BYTES(MAP) (SIZE (MAP) * sizeof *(MAP).begin)
+#define STACK_BYTES(STACK) (CAPACITY (STACK) * sizeof *(STACK).begin)
+
+static void print_memory (const char *phase) {
+  if (verbosity < 1)
+    return;
+  size_t chunk_bytes = size_arena_chunk * sizeof (int);
+  struct {
+    const char *name;
+    size_t bytes;
+  } table[] = {
+      {"clause literals", arena.literals},
+      {"clause antecedents", arena.antecedents},
+      {"arena chunks", SIZE (arena.chunks) * chunk_bytes},
+      {"spilled chunks", SIZE (arena.spilled) * chunk_bytes},
+      {"clauses.status", MAP_BYTES (clauses.status)},
+      {"clauses.literals", MAP_BYTES (clauses.literals)},
+      {"clauses.deleted", MAP_BYTES (clauses.deleted)},
+      {"clauses.added", MAP_BYTES (clauses.added)},
+      {"clauses.referenced", MAP_BYTES (clauses.referenced)},
+      {"clauses.used", MAP_BYTES (clauses.used)},
+      {"clauses.heads", MAP_BYTES (clauses.heads)},
+      {"clauses.links", MAP_BYTES (clauses.links)},
+      {"clauses.map", MAP_BYTES (clauses.map)},
+      {"variables.marks", MAP_BYTES (variables.marks)},
+      {"variables.values", MAP_BYTES (variables.values)},
+      {"parsed literals", STACK_BYTES (parsed_literals)},
+      {"parsed antecedents", STACK_BYTES (parsed_antecedents)},
+      {"unpacked antecedents", STACK_BYTES (unpacked)},
+  };
+  vrb ("memory usage after %s:", phase);
+  for (size_t i = 0; i != sizeof table / sizeof *table; i++)
+    if (table[i].bytes)
+      vrb ("  %-20s %s", table[i].name, pretty_bytes (table[i].bytes));
+}
+
+static double average (double a, double b) { return b ? a / b : 0; }
+static double percent (double a, double b) { return average (100 * a, b); }
+
+// Assigned values and resolution marks of variables are stamped with the
+// current (even) value of 'variables.stamp', which is incremented by two
+// for each checked clause, and the lowest bit holds the sign.  An entry is
+// only valid if its stamp matches the current one.  Thus neither a trail
+// of assigned variables nor unassigning them after checking a clause is
+// needed.  Only if stamps overflow both maps are cleared.
+
+#define max_stamp (UINT_MAX - 1)
+
+static void new_stamp () {
+  if (variables.stamp == max_stamp) {
+    dbg ("resetting stamps");
+    memset (variables.marks.begin, 0, MAP_BYTES (variables.marks));
+    memset (variables.values.begin, 0, MAP_BYTES (variables.values));
+    variables.stamp = 0;
+  }
+  variables.stamp += 2;
+}
+
+// Returns '1' if the stamped entry is positive, '-1' if it is negative and
+// zero if the entry is not stamped with the current stamp.
+
+static inline signed char stamped_sign (unsigned entry)
+    __attribute__ ((always_inline));
+
+static inline signed char stamped_sign (unsigned entry) {
+  unsigned delta = entry ^ variables.stamp;
+  if (delta > 1)
+    return 0;
+  return delta ? 1 : -1;
+}
+
+static inline unsigned stamp_literal (int lit) {
+  return variables.stamp | (lit > 0);
 }
 
-static inline void unassign_literal (int lit) {
+static inline void assign_literal (int lit) {
   assert (lit);
   assert (lit != INT_MIN);
-  dbg ("unassigning literal %d", lit);
+  dbg ("assigning literal %d", lit);
   int idx = abs (lit);
-  signed char *v = &ACCESS (variables.values, idx);
-#ifndef NDEBUG
-  signed char value = lit < 0 ? -1 : 1;
-  assert (*v == value);
-#endif
-  *v = 0;
-}
-
-static void backtrack () {
-  for (int *t = trail.begin; t != trail.end; t++)
-    unassign_literal (*t);
-  CLEAR (trail);
+  unsigned *v = &ACCESS (variables.values, idx);
+  assert (!stamped_sign (*v));
+  *v = stamp_literal (lit);
+  statistics.literals.assigned++;
 }
 
 static inline signed char assigned_literal (int)
-    __attribute ((always_inline));
+    __attribute__ ((always_inline));
 
 static inline signed char assigned_literal (int lit) {
   assert (lit);
   assert (lit != INT_MIN);
   int idx = abs (lit);
-  signed char res = ACCESS (variables.values, idx);
+  signed char res = stamped_sign (ACCESS (variables.values, idx));
   if (lit < 0)
     res = -res;
   return res;
 }
 
-static void crr (int, const char *, ...)
+// Long antecedents are evaluated eight literals at a time by an AVX2
+// kernel, which gathers the stamped values of their variables and masks
+// out falsified literals in a few instructions.  A literal is falsified
+// if and only if the stamp of its variable matches and the sign bit of the
+// entry differs from the sign of the literal, i.e., the entry xor'ed with
+// the current stamp is equal to the sign bit of the literal.  The kernel
+// is selected at run-time if the CPU supports AVX2 (and compiled in unless
+// configured with '--no-simd').  Otherwise and for short antecedents the
+// scalar loop in 'check_clause_non_strictly_by_propagation' is used.  The
+// kernel only determines the unique non-falsified literal of an antecedent
+// (zero if there is none) and gives up as soon as it finds two different
+// ones, which is rare and then left to the scalar loop too.  This keeps
+// the order of assignments and error messages independent of the kernel.
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(NSIMD)
+#define SIMD
+#endif
+
+#ifdef SIMD
+
+#include <immintrin.h>
+
+#define min_vectorized_antecedent 16
+#define ambiguous_unit INT_MIN
+
+static bool vectorized;
+
+__attribute__ ((target ("avx2"))) static int
+vectorized_unit (const int *literals, size_t size) {
+  const __m256i stamp = _mm256_set1_epi32 ((int)variables.stamp);
+  const int *values = (int *)variables.values.begin;
+  int res = 0;
+  size_t i = 0;
+  while (i + 8 <= size) {
+    __m256i lits = _mm256_loadu_si256 ((const __m256i *)(literals + i));
+    __m256i idx = _mm256_abs_epi32 (lits);
+    __m256i entries = _mm256_i32gather_epi32 (values, idx, 4);
+    __m256i delta = _mm256_xor_si256 (entries, stamp);
+    __m256i sign = _mm256_srli_epi32 (lits, 31);
+    __m256i falsified = _mm256_cmpeq_epi32 (delta, sign);
+    unsigned mask = _mm256_movemask_ps (_mm256_castsi256_ps (falsified));
+    for (mask ^= 0xff; mask; mask &= mask - 1) {
+      int lit = literals[i + __builtin_ctz (mask)];
+      if (res && res != lit)
+        return ambiguous_unit;
+      res = lit;
+    }
+    i += 8;
+  }
+  while (i != size) {
+    int lit = literals[i++];
+    if (assigned_literal (lit) < 0)
+      continue;
+    if (res && res != lit)
+      return ambiguous_unit;
+    res = lit;
+  }
+  return res;
+}
+
+#endif
+
+static void crr (clause_id, const char *, ...)
     __attribute__ ((format (printf, 2, 3)));
 
-static void crr (int id, const char *fmt, ...) {
+#ifndef NTHREADS
+
+// Checking threads do not report failures themselves but jump back to
+// 'check_clauses' which records the failed clause (see 'check_proof').
+
+static THREAD_LOCAL jmp_buf *checking_failed;
+static THREAD_LOCAL clause_id failed_clause;
+
+#endif
+
+static void crr (clause_id id, const char *fmt, ...) {
+#ifndef NTHREADS
+  if (checking_failed) {
+    failed_clause = id;
+    longjmp (*checking_failed, 1);
+  }
+#endif
   fputs ("lrat-trim: ", stderr);
   va_list ap;
   va_start (ap, fmt);
   vfprintf (stderr, fmt, ap);
   va_end (ap);
-  fprintf (stderr, " while checking clause '%d'", id);
+  fprintf (stderr, " while checking clause '%" PRIid "'", id);
   if (track) {
     size_t *addition = &ACCESS (clauses.added, id);
     fprintf (stderr, " at line '%zu' ", *addition);
@@ -850,50 +1861,63 @@ static void crr (int id, const char *fmt, ...) {
   exit (1);
 }
 
-static void check_clause_non_strictly_by_propagation (int id, int *literals,
-                                                      int *antecedents) {
+static void check_clause_non_strictly_by_propagation (
+    clause_id id, int *literals, clause_id *antecedents, int **resolved) {
   assert (!strict);
-  assert (EMPTY (trail));
 
   statistics.clauses.resolved++;
   for (int *l = literals, lit; (lit = *l); l++) {
     signed char value = assigned_literal (lit);
     if (value < 0) {
-      dbg ("skipping duplicated literal '%d' in clause '%d'", lit, id);
+      dbg ("skipping duplicated literal '%d' in clause '%" PRIid "'", lit,
+           id);
       continue;
     }
     if (value > 0) {
       dbg ("skipping tautological literal '%d' and '%d' "
-           "in clause '%d'",
+           "in clause '%" PRIid "'",
            -lit, lit, id);
     CHECKED:
-      backtrack ();
       return;
     }
     assign_literal (-lit);
   }
 
-  for (int *a = antecedents, aid; (aid = *a); a++) {
+  for (clause_id *a = antecedents, aid; (aid = *a); a++) {
     if (aid < 0)
-      crr (id, "checking negative RAT antecedent '%d' not supported", aid);
-    int *als = ACCESS (clauses.literals, aid);
-    dbgs (als, "resolving antecedent %d clause", aid);
+      crr (id,
+           "checking negative RAT antecedent '%" PRIid "' not supported",
+           aid);
+    int *als = resolved ? resolved[a - antecedents]
+                        : ACCESS (clauses.literals, aid);
+    dbgs (als, "resolving antecedent %" PRIid " clause", aid);
     statistics.clauses.resolved++;
-    int unit = 0;
-    for (int *l = als, lit; (lit = *l); l++) {
-      signed char value = assigned_literal (lit);
-      if (value < 0)
-        continue;
-      if (unit && unit != lit)
-        crr (id, "antecedent '%d' does not produce unit", aid);
-      unit = lit;
-      if (!value)
-        assign_literal (lit);
+    int unit;
+#ifdef SIMD
+    if (vectorized && als[-1] > min_vectorized_antecedent &&
+        (unit = vectorized_unit (als, als[-1] - 1)) != ambiguous_unit) {
+      statistics.clauses.vectorized++;
+      if (unit && !assigned_literal (unit))
+        assign_literal (unit);
+    } else
+#endif
+    {
+      unit = 0;
+      for (int *l = als, lit; (lit = *l); l++) {
+        signed char value = assigned_literal (lit);
+        if (value < 0)
+          continue;
+        if (unit && unit != lit)
+          crr (id, "antecedent '%" PRIid "' does not produce unit", aid);
+        unit = lit;
+        if (!value)
+          assign_literal (lit);
+      }
     }
     if (!unit) {
       dbgs (als,
-            "conflicting antecedent '%d' thus checking "
-            " of clause '%d' succeeded",
+            "conflicting antecedent '%" PRIid "' thus checking "
+            " of clause '%" PRIid "' succeeded",
             aid, id);
       goto CHECKED;
     }
@@ -901,15 +1925,18 @@ static void check_clause_non_strictly_by_propagation (int id, int *literals,
   crr (id, "propagating antecedents does not yield conflict");
 }
 
-static void check_clause_strictly_by_resolution (int id, int *literals,
-                                                 int *antecedents) {
+static void check_clause_strictly_by_resolution (clause_id id,
+                                                 int *literals,
+                                                 clause_id *antecedents,
+                                                 int **resolved) {
   assert (strict);
-  assert (EMPTY (trail));
 
-  int *a = antecedents, aid;
+  clause_id *a = antecedents, aid;
   while ((aid = *a))
     if (aid < 0)
-      crr (id, "checking negative RAT antecedent '%d' not supported", aid);
+      crr (id,
+           "checking negative RAT antecedent '%" PRIid "' not supported",
+           aid);
     else
       a++;
 
@@ -917,18 +1944,20 @@ static void check_clause_strictly_by_resolution (int id, int *literals,
   bool first = true;
   while (a != antecedents) {
     aid = *--a;
-    int *als = ACCESS (clauses.literals, aid);
-    dbgs (als, "resolving antecedent %d clause", aid);
+    int *als = resolved ? resolved[a - antecedents]
+                        : ACCESS (clauses.literals, aid);
+    dbgs (als, "resolving antecedent %" PRIid " clause", aid);
     statistics.clauses.resolved++;
     int unit = 0;
     for (int *l = als, lit; (lit = *l); l++) {
       assert (lit != INT_MIN);
       int idx = abs (lit);
-      signed char *m = &ACCESS (variables.marks, idx);
-      signed char mark = *m;
+      unsigned *m = &ACCESS (variables.marks, idx);
+      signed char mark = stamped_sign (*m);
       if (!mark) {
         dbg ("marking antecedent literal '%d'", lit);
-        *m = lit < 0 ? -1 : 1;
+        *m = stamp_literal (lit);
+        statistics.literals.marked++;
         resolvent_size++;
         continue;
       }
@@ -938,24 +1967,26 @@ static void check_clause_strictly_by_resolution (int id, int *literals,
         continue;
       assert (mark < 0);
       if (unit)
-        crr (id, "multiple pivots '%d' and '%d' in antecedent '%d'", unit,
-             lit, aid);
+        crr (id,
+             "multiple pivots '%d' and '%d' in antecedent '%" PRIid "'",
+             unit, lit, aid);
       unit = lit;
     }
     if (first) {
       if (unit)
-        crr (id, "multiple pivots '%d' and '%d' in antecedent '%d'", -unit,
-             unit, aid);
+        crr (id,
+             "multiple pivots '%d' and '%d' in antecedent '%" PRIid "'",
+             -unit, unit, aid);
       first = false;
     } else if (!unit)
-      crr (id, "no pivot in antecedent '%d'", aid);
+      crr (id, "no pivot in antecedent '%" PRIid "'", aid);
     else {
       dbg ("resolving over pivot literal %d", unit);
       assert (resolvent_size > 0);
       resolvent_size--;
       assert (unit != INT_MIN);
       int idx = abs (unit);
-      signed char *m = &ACCESS (variables.marks, idx);
+      unsigned *m = &ACCESS (variables.marks, idx);
       *m = 0;
     }
   }
@@ -963,8 +1994,8 @@ static void check_clause_strictly_by_resolution (int id, int *literals,
   for (int *l = literals, lit; (lit = *l); l++) {
     assert (lit != INT_MIN);
     int idx = abs (lit);
-    signed char *m = &ACCESS (variables.marks, idx);
-    signed char mark = *m;
+    unsigned *m = &ACCESS (variables.marks, idx);
+    signed char mark = stamped_sign (*m);
     if (!mark)
       crr (id, "literal '%d' not in resolvent", lit);
     if (lit < 0)
@@ -982,18 +2013,272 @@ static void check_clause_strictly_by_resolution (int id, int *literals,
     crr (id, "final resolvent has %zu additional literals", resolvent_size);
 }
 
-static void check_clause (int id, int *literals, int *antecedents) {
+// Antecedents are looked up in 'clauses.literals' unless their literals
+// are already given in 'resolved' (see 'pipeline' below).
+
+static void check_clause (clause_id id, int *literals,
+                          clause_id *antecedents, int **resolved) {
+  new_stamp ();
   statistics.clauses.checked.total++;
   if (!*literals)
     statistics.clauses.checked.empty++;
   if (strict)
-    check_clause_strictly_by_resolution (id, literals, antecedents);
+    check_clause_strictly_by_resolution (id, literals, antecedents,
+                                         resolved);
   else
-    check_clause_non_strictly_by_propagation (id, literals, antecedents);
+    check_clause_non_strictly_by_propagation (id, literals, antecedents,
+                                              resolved);
+}
+
+#ifndef NTHREADS
+
+// Forward checking with '--threads=<n>' is pipelined.  The parser adds
+// checking jobs to a bounded ring, from which '<n>' checking threads take
+// them in order, while the parser continues with the next proof line.
+// As the parser resizes 'clauses.literals', the job already contains the
+// literals of the antecedents.  Deleted clauses are still referenced by
+// jobs added before the deletion, and thus their literals are only freed
+// after all these jobs are retired.  Jobs are retired in order as soon as
+// they have been checked.  This still releases memory eagerly, bounded by
+// the size of the ring.  To reduce synchronization, idle checking threads
+// are only woken up after 'batch_jobs' jobs were added and a parser blocked
+// on a full ring only after half of it was retired.  As with parallel
+// backward checking the smallest failed clause is recorded, which is then
+// checked again to produce the same error message as sequential checking.
+// In particular parse errors are only reported after all previously added
+// jobs have been checked (see 'prr' and 'finish_pipeline').
+
+#define batch_jobs 32
+
+struct job {
+  clause_id id;
+  int *literals;
+  size_t variables;
+  struct id_stack antecedents;
+  struct ints_stack resolved;
+  bool checked;
+};
+
+struct deletion {
+  int *literals;
+  size_t added;
+};
+
+struct deletion_stack {
+  struct deletion *begin, *end, *allocated;
+};
+
+static struct {
+  struct job *jobs;
+  size_t ring, added, started, retired;
+  struct deletion_stack deleted;
+  size_t freed;
+  clause_id failed;
+  struct {
+    int *literals;
+    struct id_stack antecedents;
+    struct ints_stack resolved;
+  } failure;
+  bool stop, blocked;
+  int idle;
+  struct statistics *statistics;
+  pthread_mutex_t lock;
+  pthread_cond_t added_job, checked_job;
+  pthread_t *workers;
+} pipeline = {.lock = PTHREAD_MUTEX_INITIALIZER,
+              .added_job = PTHREAD_COND_INITIALIZER,
+              .checked_job = PTHREAD_COND_INITIALIZER};
+
+static void record_failed_job (struct job *job) {
+  if (job->id >= pipeline.failed)
+    return;
+  pipeline.failed = job->id;
+  pipeline.failure.literals = job->literals;
+  CLEAR (pipeline.failure.antecedents);
+  CLEAR (pipeline.failure.resolved);
+  for (clause_id *p = job->antecedents.begin; p != job->antecedents.end;
+       p++)
+    PUSH (pipeline.failure.antecedents, *p);
+  for (int **p = job->resolved.begin; p != job->resolved.end; p++)
+    PUSH (pipeline.failure.resolved, *p);
 }
 
-static inline bool is_original_clause (int id) {
-  int abs_id = abs (id);
+// Needs to hold the lock and returns whether a checking job failed.
+
+static bool retire_jobs () {
+  while (pipeline.retired != pipeline.started &&
+         pipeline.jobs[pipeline.retired % pipeline.ring].checked)
+    pipeline.retired++;
+  return pipeline.failed != max_clause_id;
+}
+
+static void *check_jobs (void *ptr) {
+  struct statistics *result = ptr;
+  jmp_buf jump;
+  checking_failed = &jump;
+  pthread_mutex_lock (&pipeline.lock);
+  for (;;) {
+    while (pipeline.started == pipeline.added && !pipeline.stop) {
+      pipeline.idle++;
+      pthread_cond_wait (&pipeline.added_job, &pipeline.lock);
+      pipeline.idle--;
+    }
+    if (pipeline.started == pipeline.added)
+      break;
+    struct job *job = pipeline.jobs + pipeline.started++ % pipeline.ring;
+    bool skip = job->id > pipeline.failed;
+    pthread_mutex_unlock (&pipeline.lock);
+    bool failed = false;
+    if (!skip) {
+      if (strict)
+        ADJUST (variables.marks, job->variables);
+      else
+        ADJUST (variables.values, job->variables);
+      if (setjmp (jump))
+        failed = true;
+      else
+        check_clause (job->id, job->literals, job->antecedents.begin,
+                      job->resolved.begin);
+    }
+    pthread_mutex_lock (&pipeline.lock);
+    if (failed)
+      record_failed_job (job);
+    job->checked = true;
+    if (pipeline.blocked &&
+        (retire_jobs () ||
+         pipeline.added - pipeline.retired <= pipeline.ring / 2))
+      pthread_cond_signal (&pipeline.checked_job);
+  }
+  pthread_mutex_unlock (&pipeline.lock);
+  checking_failed = 0;
+  *result = statistics;
+  RELEASE_MAP (variables.marks);
+  RELEASE_MAP (variables.values);
+  return 0;
+}
+
+static void start_pipeline () {
+  pipeline.ring = 256 * (size_t)threads;
+  pipeline.jobs = calloc (pipeline.ring, sizeof *pipeline.jobs);
+  pipeline.workers = calloc (threads, sizeof *pipeline.workers);
+  pipeline.statistics = calloc (threads, sizeof *pipeline.statistics);
+  if (!pipeline.jobs || !pipeline.workers || !pipeline.statistics)
+    die ("out-of-memory allocating checking pipeline");
+  pipeline.failed = max_clause_id;
+  vrb ("forward checking with %d threads", threads);
+  for (int i = 0; i != threads; i++)
+    if (pthread_create (pipeline.workers + i, 0, check_jobs,
+                        pipeline.statistics + i))
+      die ("failed to start checking thread");
+}
+
+static void free_deleted_clauses (size_t retired) {
+  struct deletion *begin = pipeline.deleted.begin;
+  struct deletion *end = pipeline.deleted.end;
+  struct deletion *p = begin + pipeline.freed;
+  while (p != end && p->added <= retired)
+    delete_clause ((p++)->literals);
+  if (p == end) {
+    CLEAR (pipeline.deleted);
+    pipeline.freed = 0;
+  } else
+    pipeline.freed = p - begin;
+}
+
+static void delay_deletion (int *literals) {
+  struct deletion deletion = {literals, pipeline.added};
+  PUSH (pipeline.deleted, deletion);
+}
+
+static void add_job (clause_id id, int *literals, clause_id *antecedents) {
+  pthread_mutex_lock (&pipeline.lock);
+  bool failed;
+  if (!(failed = retire_jobs ()) &&
+      pipeline.added - pipeline.retired == pipeline.ring) {
+    pipeline.blocked = true;
+    while (!(failed = retire_jobs ()) &&
+           pipeline.added - pipeline.retired > pipeline.ring / 2)
+      pthread_cond_wait (&pipeline.checked_job, &pipeline.lock);
+    pipeline.blocked = false;
+  }
+  size_t retired = pipeline.retired;
+  pthread_mutex_unlock (&pipeline.lock);
+  if (failed)
+    finish_pipeline ();
+  free_deleted_clauses (retired);
+  struct job *job = pipeline.jobs + pipeline.added % pipeline.ring;
+  job->id = id;
+  job->literals = literals;
+  job->variables =
+      (strict ? SIZE (variables.marks) : SIZE (variables.values)) - 1;
+  job->checked = false;
+  CLEAR (job->antecedents);
+  CLEAR (job->resolved);
+  for (clause_id *p = antecedents, aid;; p++) {
+    PUSH (job->antecedents, (aid = *p));
+    if (!aid)
+      break;
+    PUSH (job->resolved, aid > 0 ? ACCESS (clauses.literals, aid) : 0);
+  }
+  pthread_mutex_lock (&pipeline.lock);
+  pipeline.added++;
+  if (pipeline.idle && pipeline.added - pipeline.started >= batch_jobs)
+    pthread_cond_signal (&pipeline.added_job);
+  pthread_mutex_unlock (&pipeline.lock);
+}
+
+// Waits until all jobs are checked and stops the checking threads.  If a
+// job failed, the failed clause with the smallest identifier is checked
+// again, which reports the error and exits.
+
+static void finish_pipeline () {
+  if (!pipeline.workers)
+    return;
+  pthread_mutex_lock (&pipeline.lock);
+  pipeline.stop = true;
+  pthread_cond_broadcast (&pipeline.added_job);
+  pipeline.blocked = true;
+  while (retire_jobs (), pipeline.retired != pipeline.added)
+    pthread_cond_wait (&pipeline.checked_job, &pipeline.lock);
+  pthread_mutex_unlock (&pipeline.lock);
+  for (int i = 0; i != threads; i++)
+    if (pthread_join (pipeline.workers[i], 0))
+      die ("failed to join checking thread");
+  free (pipeline.workers);
+  pipeline.workers = 0;
+  for (int i = 0; i != threads; i++) {
+    struct statistics *s = pipeline.statistics + i;
+    statistics.clauses.checked.total += s->clauses.checked.total;
+    statistics.clauses.checked.empty += s->clauses.checked.empty;
+    statistics.clauses.resolved += s->clauses.resolved;
+    statistics.clauses.vectorized += s->clauses.vectorized;
+    statistics.literals.assigned += s->literals.assigned;
+    statistics.literals.marked += s->literals.marked;
+  }
+  free (pipeline.statistics);
+  if (pipeline.failed != max_clause_id) {
+    clause_id id = pipeline.failed;
+    int *l = pipeline.failure.literals;
+    ACCESS (clauses.literals, id) = l;
+    check_clause (id, l, pipeline.failure.antecedents.begin,
+                  pipeline.failure.resolved.begin);
+    assert (!"checking failed clause again should have failed");
+  }
+  free_deleted_clauses (pipeline.added);
+  RELEASE (pipeline.deleted);
+  for (size_t i = 0; i != pipeline.ring; i++) {
+    RELEASE (pipeline.jobs[i].antecedents);
+    RELEASE (pipeline.jobs[i].resolved);
+  }
+  free (pipeline.jobs);
+  RELEASE (pipeline.failure.antecedents);
+  RELEASE (pipeline.failure.resolved);
+}
+
+#endif
+
+static inline bool is_original_clause (clause_id id) {
+  clause_id abs_id = id < 0 ? -id : id;
   return !abs_id || !first_clause_added_in_proof ||
          abs_id < first_clause_added_in_proof;
 }
@@ -1021,18 +2306,110 @@ static inline bool faster_than_default_isdigit (int ch) {
   return '0' <= ch && ch <= '9';
 }
 
+// Even with this optimization reading and checking digits one character at
+// a time dominates parsing of ASCII proofs.  Therefore, if at least eight
+// characters are left in the buffer, we use 'SIMD within a register' to
+// determine in one go how many of the next eight characters are digits and
+// convert these leading digits in bulk to an integer.  This is only done
+// after a non-zero first digit was read, which is passed in as 'res', and
+// then at most eight further digits can not overflow 'INT_MAX'.  Additional
+// digits, the terminating character and all errors are handled by the
+// original character based parsing loops following calls to this function.
+
+static inline int read_more_digits (int) __attribute__ ((always_inline));
+
+static inline int read_more_digits (int res) {
+  assert (0 < res && res < 10);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if (buffer.end - buffer.pos < 8)
+    return res;
+  uint64_t word;
+  memcpy (&word, buffer.chars + buffer.pos, 8);
+  const uint64_t ones = 0x0101010101010101;
+  uint64_t high = word & (0xf0 * ones);
+  uint64_t plus6 = (word + 6 * ones) & (0xf0 * ones);
+  uint64_t non_digits = (high ^ (0x30 * ones)) | (plus6 ^ (0x30 * ones));
+  unsigned digits = non_digits ? __builtin_ctzll (non_digits) / 8 : 8;
+  if (!digits)
+    return res;
+  uint64_t val = (word & (0x0f * ones)) << (8 * (8 - digits));
+  val = ((val & 0x0f0f0f0f0f0f0f0f) * 2561) >> 8;
+  val = ((val & 0x00ff00ff00ff00ff) * 6553601) >> 16;
+  val = ((val & 0x0000ffff0000ffff) * 42949672960001) >> 32;
+  static const int scale[9] = {1,      10,      100,      1000,     10000,
+                               100000, 1000000, 10000000, 100000000};
+  res = res * scale[digits] + (int)val;
+  buffer.pos += digits;
+  input.bytes += digits;
+  input.last = buffer.chars[buffer.pos - 1];
+#endif
+  return res;
+}
+
+// Binary proofs encode integers as variable length little-endian bytes
+// with the highest bit as continuation flag.  Decoding them byte by byte
+// as in the loops of 'parse_proof' branches once per byte on the unknown
+// length.  Instead 'peek_varint' loads eight bytes at once, determines the
+// length of the encoding from the first cleared continuation bit and then
+// gathers the seven bit groups with masks and shifts.  The decoded value is
+// stored in 'res' and the number of bytes of its encoding returned, but
+// nothing is consumed yet, which is left to 'skip_varint'.  If fewer than
+// eight bytes are buffered, or if the encoding is invalid, i.e., too long,
+// exceeds 32 bits or ends with a zero byte, then zero is returned and the
+// caller falls back to the original byte based loop which then produces
+// exactly the same error messages as before.
+
+static inline unsigned peek_varint (unsigned *)
+    __attribute__ ((always_inline));
+
+static inline unsigned peek_varint (unsigned *res) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if (buffer.end - buffer.pos < 8)
+    return 0;
+  uint64_t word;
+  memcpy (&word, buffer.chars + buffer.pos, 8);
+  const uint64_t stops = ~word & 0x8080808080808080;
+  if (!stops)
+    return 0;
+  const unsigned bytes = __builtin_ctzll (stops) / 8 + 1;
+  if (bytes > 5)
+    return 0;
+  const unsigned last = (word >> (8 * (bytes - 1))) & 255;
+  if (bytes > 1 && !last)
+    return 0;
+  if (bytes == 5 && last > 15)
+    return 0;
+  word &= ((uint64_t)1 << (8 * bytes)) - 1;
+  *res = (word & 0x7f) | ((word >> 1) & 0x3f80) |
+         ((word >> 2) & 0x1fc000) | ((word >> 3) & 0xfe00000) |
+         ((word >> 4) & 0xf0000000);
+  return bytes;
+#else
+  (void)res;
+  return 0;
+#endif
+}
+
+static inline void skip_varint (unsigned bytes) {
+  assert (bytes);
+  assert (buffer.pos + bytes <= buffer.end);
+  buffer.pos += bytes;
+  input.bytes += bytes;
+}
+
 // If the user does have huge integers (larger than 'INT_MAX') in proofs we
 // still want to print those integers in the triggered error message.  This
 // function takes the integer 'n' parsed so far and the digit 'ch'
 // triggering the overflow as argument and then continues reading digits
 // from the input file (for a while) and prints the complete parsed integer
-// string to a statically allocated buffer which is returned.
+// string to a statically allocated buffer which is returned.  The same
+// applies to clause identifiers larger than 'max_clause_id'.
 
-static const char *exceeds_int_max (int n, int ch) {
+static const char *exceeds_int_max (clause_id n, int ch) {
   static char buffer[32];
   const size_t size = sizeof buffer - 5;
   assert (ISDIGIT (ch));
-  snprintf (buffer, sizeof buffer, "%d", n);
+  snprintf (buffer, sizeof buffer, "%" PRIid, n);
   size_t i = strlen (buffer);
   do {
     assert (i < sizeof buffer);
@@ -1060,6 +2437,7 @@ static void parse_cnf () {
   vrb ("starting parsing CNF after %.2f seconds", start);
   input = *cnf.input;
   msg ("reading CNF from '%s'", input.path);
+  start_reading ();
   int ch;
   for (ch = read_first_char (); ch != 'p'; ch = read_ascii ())
     if (ch != 'c')
@@ -1125,6 +2503,7 @@ static void parse_cnf () {
   int lit = 0, parsed_clauses = 0;
   struct int_stack parsed_literals;
   ZERO (parsed_literals);
+  size_t offset = 0;
   for (;;) {
     ch = read_ascii ();
     if (ch == ' ' || ch == '\t' || ch == '\n')
@@ -1148,6 +2527,10 @@ static void parse_cnf () {
           prr ("end-of-file in comment after header");
       continue;
     }
+    if (lazy_literals && EMPTY (parsed_literals)) {
+      assert (buffer.chars == input.map);
+      offset = buffer.pos - 1;
+    }
     int sign;
     if (ch == '-') {
       ch = read_ascii ();
@@ -1162,6 +2545,8 @@ static void parse_cnf () {
       sign = 1;
     }
     int idx = ch - '0';
+    if (idx)
+      idx = read_more_digits (idx);
     while (ISDIGIT (ch = read_ascii ())) {
       if (!idx)
         prr ("unexpected digit '%c' after '0'", ch);
@@ -1190,16 +2575,12 @@ static void parse_cnf () {
       statistics.original.cnf.added++;
       dbgs (parsed_literals.begin, "clause %d parsed", parsed_clauses);
       size_t size_literals = SIZE (parsed_literals);
-      size_t bytes_literals = size_literals * sizeof (int);
-      int *l = malloc (bytes_literals);
-      if (!l) {
-        assert (size_literals);
-        die ("out-of-memory allocating literals of size %zu clause %d",
-             size_literals - 1, parsed_clauses);
-      }
-      memcpy (l, parsed_literals.begin, bytes_literals);
       assert (parsed_clauses < SIZE (clauses.literals));
-      clauses.literals.begin[parsed_clauses] = l;
+      if (lazy_literals)
+        new_lazy_clause (parsed_clauses, offset, 0, 0);
+      else
+        new_clause (parsed_clauses, parsed_literals.begin, size_literals, 0,
+                    0);
       CLEAR (parsed_literals);
       assert (parsed_clauses < SIZE (clauses.status));
       clauses.status.begin[parsed_clauses] = 1;
@@ -1216,8 +2597,7 @@ static void parse_cnf () {
   assert (EMPTY (parsed_literals));
   RELEASE (parsed_literals);
 
-  if (input.close)
-    fclose (input.file);
+  stop_reading ();
   *cnf.input = input;
 
   vrb ("read %zu CNF lines with %s", input.lines,
@@ -1230,21 +2610,91 @@ static void parse_cnf () {
   vrb ("finished parsing CNF after %.2f seconds", end);
   msg ("parsing original CNF took %.2f seconds and needed %.0f MB memory",
        duration, mega_bytes ());
+  print_memory ("parsing CNF");
 
   variables.original = header_variables;
 }
 
 static size_t ignored_deletions = 0;
-static struct int_stack parsed_literals;
-static struct int_stack parsed_antecedents;
 
-static void delete_antecedent (int other, bool binary, size_t info) {
+// Without CNF all identifiers below the first clause added in the proof
+// denote original clauses.  Their status is not set explicitly when the
+// first clause is added, which would take time and memory linear in its
+// identifier, but a zero status in this range is interpreted as added.
+
+static signed char clause_status (clause_id id) {
+  signed char status = ACCESS (clauses.status, id);
+  if (!status && !last_clause_added_in_cnf &&
+      id < first_clause_added_in_proof)
+    status = 1;
+  return status;
+}
+
+// While trimming, clauses are kept until the end, as they might end up in
+// the core.  However, a deleted clause can not be used as antecedent any
+// more.  Thus if it was not used as antecedent before either, it can not
+// be in the core (unless it is the empty clause).  To reclaim such garbage
+// clauses online during parsing, we count in 'clauses.referenced' how
+// often a clause is used as antecedent and release a deleted clause as
+// soon as this count drops to zero.  Releasing a clause decrements the
+// counts of its antecedents, which in turn might release those which were
+// already deleted.  Counts saturate at 'INT_MAX' and then stay there.
+
+static size_t collected_clauses;
+
+static void reference_antecedents (clause_id id, clause_id *antecedents) {
+  ADJUST (clauses.referenced, id);
+  for (clause_id *p = antecedents, other; (other = *p); p++) {
+    if (other < 0)
+      other = -other;
+    int *count = &ACCESS (clauses.referenced, other);
+    if (*count != INT_MAX)
+      ++*count;
+  }
+}
+
+static bool garbage_clause (clause_id id) {
+  return id != empty_clause && ACCESS (clauses.status, id) < 0 &&
+         (id >= SIZE (clauses.referenced) ||
+          !ACCESS (clauses.referenced, id));
+}
+
+static void collect_garbage_clause (clause_id id) {
+  static struct id_stack garbage;
+  assert (EMPTY (garbage));
+  PUSH (garbage, id);
+  while (!EMPTY (garbage)) {
+    id = POP (garbage);
+    int **p = &ACCESS (clauses.literals, id);
+    int *l = *p;
+    if (!l)
+      continue;
+    dbg ("collecting unreferenced deleted clause %" PRIid, id);
+    clause_id *a = unpack_antecedents (id, l);
+    for (clause_id other; (other = *a); a++) {
+      if (other < 0)
+        other = -other;
+      int *count = &ACCESS (clauses.referenced, other);
+      if (*count == INT_MAX)
+        continue;
+      assert (*count > 0);
+      if (!--*count && garbage_clause (other))
+        PUSH (garbage, other);
+    }
+    delete_clause (l);
+    *p = 0;
+    collected_clauses++;
+  }
+  RELEASE (garbage);
+  ZERO (garbage);
+}
+
+static void delete_antecedent (clause_id other, bool binary, size_t info) {
   if (!first_clause_added_in_proof)
     ADJUST (clauses.status, other);
 
-  signed char *status_ptr = &ACCESS (clauses.status, other);
-  signed char status = *status_ptr;
-  *status_ptr = -1;
+  signed char status = clause_status (other);
+  ACCESS (clauses.status, other) = -1;
 
   size_t *other_deletion = 0;
 
@@ -1266,7 +2716,7 @@ static void delete_antecedent (int other, bool binary, size_t info) {
     else if (relax)
       ignored_deletions++;
     else
-      prr ("deleted clause '%d' at %s %zu "
+      prr ("deleted clause '%" PRIid "' at %s %zu "
            "is neither an original clause nor has been added "
            "(use '--relax' to ignore such deletions)",
            other, binary ? "byte" : "line", info);
@@ -1277,13 +2727,13 @@ static void delete_antecedent (int other, bool binary, size_t info) {
       ignored_deletions++;
     else if (track) {
       assert (*other_deletion);
-      prr ("clause %d requested to be deleted at %s %zu "
+      prr ("clause %" PRIid " requested to be deleted at %s %zu "
            "was already deleted at %s %zu "
            "(use '--relax' to ignore such deletions)",
            other, binary ? "byte" : "line", info, binary ? "byte" : "line",
            *other_deletion);
     } else
-      prr ("clause %d requested to be deleted "
+      prr ("clause %" PRIid " requested to be deleted "
            "at %s %zu was already deleted before "
            "(use '--relax' to ignore such deletions and "
            "with '--track' for more information)",
@@ -1294,7 +2744,7 @@ static void delete_antecedent (int other, bool binary, size_t info) {
   // requested and the clause was never added or got now deleted.
 
   if (track && status >= 0) {
-    dbg ("marked clause %d to be deleted at %s %zu", other,
+    dbg ("marked clause %" PRIid " to be deleted at %s %zu", other,
          binary ? "byte" : "line", info);
     *other_deletion = info;
   }
@@ -1320,36 +2770,762 @@ static void delete_antecedent (int other, bool binary, size_t info) {
     assert (!proof.output);
     assert (!cnf.output);
 
-    assert (EMPTY (clauses.antecedents));
-
     // TODO the logic here needs documentation!!!!
 
     if (!relax || other < SIZE (clauses.literals)) {
 
       int **l = &ACCESS (clauses.literals, other);
-      free (*l);
+#ifndef NTHREADS
+      if (*l && pipeline.workers)
+        delay_deletion (*l);
+      else
+#endif
+      if (*l)
+        delete_clause (*l);
       *l = 0;
     }
-  }
+  } else if (trimming && status > 0 && garbage_clause (other))
+    collect_garbage_clause (other);
 
 #if !defined(NDEBUG) || defined(LOGGING)
   PUSH (parsed_antecedents, other);
 #endif
 }
 
+// The following functions implement the checks and updates for added
+// clauses which depend on previously parsed proof lines.  They are shared
+// between the sequential parser in 'parse_proof' and merging of chunks
+// parsed in parallel (see 'merge_chunk' below).
+
+static void check_addition (clause_id id, clause_id last_id) {
+  if (id == last_id)
+    prr ("line identifier '%" PRIid "' of addition line does not increase",
+         id);
+  if (!first_clause_added_in_proof) {
+    if (last_clause_added_in_cnf) {
+      if (last_clause_added_in_cnf == id)
+        prr ("first added clause %" PRIid " in proof "
+             "has same identifier as last original clause",
+             id);
+      else if (last_clause_added_in_cnf > id)
+        prr ("first added clause %" PRIid " in proof "
+             "has smaller identifier as last original clause %" PRIid,
+             id, last_clause_added_in_cnf);
+    }
+    vrb ("adding first clause %" PRIid " in proof", id);
+    first_clause_added_in_proof = id;
+    if (!last_clause_added_in_cnf) {
+      assert (!statistics.original.cnf.added);
+      statistics.original.cnf.added = id - 1;
+    }
+  }
+}
+
+static void check_literals (clause_id id, size_t size_literals) {
+  assert (size_literals > 0);
+  if (size_literals == 1) {
+    if (!empty_clause) {
+      vrb ("found empty clause %" PRIid, id);
+      statistics.clauses.checked.empty++;
+      empty_clause = id;
+    }
+  }
+}
+
+static void check_antecedent (clause_id id, clause_id signed_other,
+                              bool binary) {
+  clause_id other = signed_other < 0 ? -signed_other : signed_other;
+  if (other >= id)
+    prr ("antecedent '%" PRIid "' in clause %" PRIid " exceeds clause",
+         signed_other, id);
+  signed char status = clause_status (other);
+  if (!status)
+    prr ("antecedent '%" PRIid "' in clause %" PRIid " "
+         "is neither an original clause nor has been added",
+         signed_other, id);
+  else if (status < 0) {
+    if (track) {
+      size_t info = ACCESS (clauses.deleted, other);
+      assert (info);
+      prr ("antecedent %" PRIid " in clause %" PRIid
+           " was deleted at %s %zu",
+           signed_other, id, binary ? "byte" : "clause", info);
+    } else
+      prr ("antecedent %" PRIid " in clause %" PRIid " was deleted before "
+           "(run with '--track' for more information)",
+           other, id);
+  }
+}
+
+// Lemmas in the proof might contain variables which do not occur in the
+// CNF and thus exceed the maximum variable given in its header.
+
+static void adjust_variables (int *literals) {
+  int max_variable = 0;
+  for (int *l = literals, lit; (lit = *l); l++) {
+    int idx = abs (lit);
+    if (idx > max_variable)
+      max_variable = idx;
+  }
+  if (strict)
+    ADJUST (variables.marks, max_variable);
+  else
+    ADJUST (variables.values, max_variable);
+}
+
+static void add_clause (clause_id id, int *literals, size_t size_literals,
+                        clause_id *antecedents, size_t size_antecedents,
+                        size_t info, size_t offset) {
+  assert (size_literals > 0);
+  assert (size_antecedents > 0);
+  if (track) {
+    ADJUST (clauses.added, id);
+    size_t *addition = &ACCESS (clauses.added, id);
+    *addition = info;
+  }
+  statistics.original.proof.added++;
+  if (trimming)
+    reference_antecedents (id, antecedents);
+  if (checking)
+    adjust_variables (literals);
+  if (checking && forward) {
+    int *l = new_clause (id, literals, size_literals, 0, 0);
+#ifndef NTHREADS
+    if (pipeline.workers) {
+      add_job (id, l, antecedents);
+      dbg ("added forward checking job for clause %" PRIid, id);
+    } else
+#endif
+    {
+      check_clause (id, l, antecedents, 0);
+      dbg ("forward checked clause %" PRIid, id);
+    }
+  } else if (lazy_literals)
+    new_lazy_clause (id, offset, antecedents, size_antecedents);
+  else if (trimming || checking)
+    new_clause (id, literals, size_literals, antecedents, size_antecedents);
+  else
+    new_clause (id, literals, size_literals, 0, 0);
+  ACCESS (clauses.status, id) = 1;
+}
+
+// Binary proofs written with '--framed' consist of frames, which start with
+// a header byte 'f' followed by the size of the frame in bytes, the first
+// added clause in the frame and the number of added clauses in the frame,
+// all as variable length encoded unsigned integers.  The sequential parser
+// checks that proof lines do not cross frame boundaries and that the header
+// information matches the frame.  These headers allow to find frames
+// without parsing the proof lines in between (see below).
+
+static struct {
+  size_t end;
+  unsigned clauses, added;
+  clause_id first;
+  bool open;
+} frame;
+
+// The last seven bit group of a variable length encoded clause identifier
+// (shifted by one for the sign) has to fit into the remaining bits.
+
+#define bits_clause_id (8 * sizeof (clause_id))
+#define last_clause_id_shift ((bits_clause_id - 1) / 7 * 7)
+
+static inline bool excessive_clause_id_byte (unsigned shift, unsigned uch) {
+  return shift == last_clause_id_shift &&
+         (uch >> (bits_clause_id - last_clause_id_shift));
+}
+
+static unsigned_clause_id read_frame_field (const char *name) {
+  unsigned_clause_id res = 0;
+  unsigned shift = 0;
+  for (;;) {
+    int ch = read_binary ();
+    if (ch == EOF)
+      prr ("end-of-file parsing %s in frame header", name);
+    if (shift && !ch)
+      prr ("invalid zero byte in %s in frame header", name);
+    unsigned uch = ch;
+    if (excessive_clause_id_byte (shift, uch))
+      prr ("excessive %s in frame header", name);
+    res |= (unsigned_clause_id)(uch & 127) << shift;
+    if (!(uch & 128))
+      return res;
+    shift += 7;
+  }
+}
+
+static void read_frame_header () {
+  unsigned_clause_id bytes = read_frame_field ("size");
+  if (bytes > UINT_MAX)
+    prr ("excessive size in frame header");
+  unsigned_clause_id first = read_frame_field ("first clause");
+  if (first > (unsigned_clause_id)max_clause_id)
+    prr ("first clause identifier %" PRIuid " in frame header too large",
+         first);
+  unsigned_clause_id clauses = read_frame_field ("number of clauses");
+  if (clauses > UINT_MAX)
+    prr ("excessive number of clauses in frame header");
+  frame.end = input.bytes + bytes;
+  frame.first = first;
+  frame.clauses = clauses;
+  frame.added = 0;
+  frame.open = true;
+  dbg ("frame of %u bytes with %u clauses starting with clause %" PRIid,
+       (unsigned)bytes, frame.clauses, frame.first);
+}
+
+static void close_frame () {
+  assert (frame.open);
+  if (frame.added != frame.clauses)
+    prr ("frame ending at byte %zu has %u instead of %u added clauses",
+         frame.end, frame.added, frame.clauses);
+  frame.open = false;
+}
+
+#ifndef NTHREADS
+
+// ASCII proof lines can only be checked in order, but tokenizing them,
+// which dominates parsing time, is independent for each line.  Thus with
+// '--threads=<n>' the remaining part of a mapped proof is cut at new-lines
+// into chunks, which are tokenized by '<n>' worker threads into integer
+// records.  The main thread merges these records in order and applies all
+// the checks which depend on previous lines, i.e., identifier order and
+// the status of deleted clauses and antecedents, through the same
+// functions as the sequential parser.  Workers simply stop at the first
+// line they do not accept, which includes all syntactically invalid lines.
+// After merging the records before that line the main thread continues
+// with the sequential parser at its start, which then produces the same
+// error message (and line number) as without threads.  If the sequential
+// parser accepts the line instead, parallel parsing is resumed after it.
+// As a safe-guard against proofs with many such lines, the number of lines
+// parsed sequentially before resuming doubles every time.
+
+// Binary proofs can not be cut at arbitrary positions, but proofs written
+// with '--framed' consist of frames with headers giving their size, the
+// first added clause and the number of added clauses (see 'write_frame').
+// For such proofs the main thread first follows the chain of frame headers
+// and then the frames are decoded by the workers as chunks.  Frames are
+// only accepted as a whole.  Otherwise sequential parsing resumes at the
+// header of the first frame not accepted.
+
+// Each record starts with the line offset within its chunk (the byte offset
+// for frames), followed by the type ('a' or 'd'), the clause identifier
+// (zero for binary deletions) and then zero terminated lists of literals
+// and antecedents or of deleted clauses.  For added clauses the literals
+// are preceded by their byte offset within the chunk (for '--lazy').
+
+#define min_chunk_size (1u << 12)
+#define max_chunk_size (1u << 20)
+
+struct chunk {
+  const unsigned char *begin, *end, *stopped;
+  struct id_stack records;
+  size_t lines;
+  bool parsed;
+};
+
+struct frame_header {
+  const unsigned char *header, *begin, *end;
+  unsigned clauses;
+  clause_id first;
+};
+
+static struct {
+  const unsigned char *begin, *end, *resume;
+  size_t size, total, next, merged, offset;
+  struct chunk *chunks;
+  size_t ring, resume_line, sequential_lines;
+  bool binary, stop;
+  struct {
+    struct frame_header *begin, *end, *allocated;
+  } frames;
+  pthread_mutex_t lock;
+  pthread_cond_t parsed, released;
+  pthread_t *workers;
+} parallel = {.lock = PTHREAD_MUTEX_INITIALIZER,
+              .parsed = PTHREAD_COND_INITIALIZER,
+              .released = PTHREAD_COND_INITIALIZER};
+
+static bool parse_in_parallel;
+
+static const unsigned char *chunk_boundary (size_t i) {
+  if (!i)
+    return parallel.begin;
+  if (i >= parallel.total)
+    return parallel.end;
+  const unsigned char *p = parallel.begin + i * parallel.size - 1;
+  const unsigned char *q = memchr (p, '\n', parallel.end - p);
+  return q ? q + 1 : parallel.end;
+}
+
+static inline bool tokenize_number (const unsigned char **p_ptr,
+                                    const unsigned char *end,
+                                    clause_id max, clause_id *res) {
+  const unsigned char *p = *p_ptr;
+  if (p == end || !ISDIGIT (*p))
+    return false;
+  clause_id n = *p++ - '0';
+  while (p != end && ISDIGIT (*p)) {
+    if (!n || max / 10 < n)
+      return false;
+    n *= 10;
+    int digit = *p++ - '0';
+    if (max - digit < n)
+      return false;
+    n += digit;
+  }
+  *p_ptr = p;
+  *res = n;
+  return true;
+}
+
+static inline bool tokenize_signed (const unsigned char **p_ptr,
+                                    const unsigned char *end,
+                                    clause_id max, clause_id *res) {
+  bool negative = *p_ptr != end && **p_ptr == '-';
+  if (negative)
+    ++*p_ptr;
+  if (!tokenize_number (p_ptr, end, max, res))
+    return false;
+  if (negative) {
+    if (!*res)
+      return false;
+    *res = -*res;
+  }
+  return true;
+}
+
+// As 'read_ascii' the tokenizer accepts a carriage-return right before a
+// new-line (and only there) and then reads them as a single new-line.
+
+static inline int tokenize_char (const unsigned char **p_ptr,
+                                 const unsigned char *end) {
+  const unsigned char *p = *p_ptr;
+  int ch = *p++;
+  if (ch == '\r' && p != end && *p == '\n')
+    ch = *p++;
+  *p_ptr = p;
+  return ch;
+}
+
+static void tokenize_chunk (struct chunk *chunk) {
+  const unsigned char *p = chunk->begin, *end = chunk->end;
+  struct id_stack *records = &chunk->records;
+  CLEAR (*records);
+  const unsigned char *line = p;
+  size_t size = 0;
+  int lines = 0;
+  while (p != end) {
+    line = p;
+    size = SIZE (*records);
+    int ch = *p;
+    if (ch == 'c' || ch == 's' || ch == 'v') {
+      while (p != end && *p != '\n' && *p != '\r')
+        p++;
+      if (p == end || tokenize_char (&p, end) != '\n')
+        goto STOP;
+      lines++;
+      continue;
+    }
+    clause_id id;
+    if (!tokenize_number (&p, end, max_clause_id, &id) || p == end ||
+        *p++ != ' ')
+      goto STOP;
+    PUSH (*records, lines);
+    if (p != end && *p == 'd') {
+      if (++p == end || *p++ != ' ')
+        goto STOP;
+      PUSH (*records, 'd');
+      PUSH (*records, id);
+      clause_id other;
+      do {
+        if (!tokenize_number (&p, end, max_clause_id, &other) || p == end)
+          goto STOP;
+        ch = tokenize_char (&p, end);
+        if (other ? ch != ' ' || (id && other > id) : ch != '\n')
+          goto STOP;
+        PUSH (*records, other);
+      } while (other);
+    } else {
+      PUSH (*records, 'a');
+      PUSH (*records, id);
+      PUSH (*records, p - chunk->begin);
+      clause_id lit;
+      do {
+        if (!tokenize_signed (&p, end, INT_MAX, &lit) || p == end ||
+            *p++ != ' ')
+          goto STOP;
+        PUSH (*records, lit);
+      } while (lit);
+      clause_id other;
+      do {
+        if (!tokenize_signed (&p, end, max_clause_id, &other) || p == end)
+          goto STOP;
+        ch = tokenize_char (&p, end);
+        if (ch != (other ? ' ' : '\n'))
+          goto STOP;
+        PUSH (*records, other);
+      } while (other);
+    }
+    lines++;
+  }
+  chunk->stopped = 0;
+  chunk->lines = lines;
+  return;
+STOP:
+  records->end = records->begin + size;
+  chunk->stopped = line;
+  chunk->lines = lines;
+}
+
+// Same as the sequential binary parser this decoder rejects zero bytes in
+// continuation positions, which makes accepted encodings unique and allows
+// to recompute byte offsets from decoded values in 'merge_chunk'.
+
+static inline const unsigned char *
+decode_varint (const unsigned char *p, const unsigned char *end,
+               unsigned_clause_id *res) {
+  unsigned_clause_id u = 0;
+  unsigned shift = 0;
+  for (;;) {
+    if (p == end)
+      return 0;
+    unsigned uch = *p++;
+    if (shift && !uch)
+      return 0;
+    if (excessive_clause_id_byte (shift, uch))
+      return 0;
+    u |= (unsigned_clause_id)(uch & 127) << shift;
+    if (!(uch & 128))
+      break;
+    shift += 7;
+  }
+  *res = u;
+  return p;
+}
+
+static void tokenize_frame (struct chunk *chunk,
+                            const struct frame_header *frame_header) {
+  const unsigned char *p = chunk->begin, *end = chunk->end;
+  struct id_stack *records = &chunk->records;
+  CLEAR (*records);
+  unsigned added = 0;
+  int lines = 0;
+  while (p != end) {
+    PUSH (*records, p - chunk->begin);
+    int type = *p++;
+    unsigned_clause_id u;
+    if (type == 'a') {
+      if (!(p = decode_varint (p, end, &u)) || !u || (u & 1))
+        goto STOP;
+      clause_id id = u >> 1;
+      if (!added++ && id != frame_header->first)
+        goto STOP;
+      PUSH (*records, 'a');
+      PUSH (*records, id);
+      PUSH (*records, p - chunk->begin);
+      do {
+        if (!(p = decode_varint (p, end, &u)) || u == 1 || u > UINT_MAX)
+          goto STOP;
+        int idx = u >> 1;
+        PUSH (*records, (u & 1) ? -idx : idx);
+      } while (u);
+      do {
+        if (!(p = decode_varint (p, end, &u)) || u == 1)
+          goto STOP;
+        clause_id other = u >> 1;
+        PUSH (*records, (u & 1) ? -other : other);
+      } while (u);
+    } else if (type == 'd') {
+      PUSH (*records, 'd');
+      PUSH (*records, 0);
+      do {
+        if (!(p = decode_varint (p, end, &u)) || (u & 1))
+          goto STOP;
+        PUSH (*records, (clause_id)(u >> 1));
+      } while (u);
+    } else
+      goto STOP;
+    lines++;
+  }
+  if (added != frame_header->clauses)
+    goto STOP;
+  chunk->stopped = 0;
+  chunk->lines = lines;
+  return;
+STOP:
+  CLEAR (*records);
+  chunk->stopped = frame_header->header;
+  chunk->lines = 0;
+}
+
+static void *parse_chunks (void *dummy) {
+  (void)dummy;
+  pthread_mutex_lock (&parallel.lock);
+  for (;;) {
+    while (!parallel.stop && parallel.next != parallel.total &&
+           parallel.next - parallel.merged == parallel.ring)
+      pthread_cond_wait (&parallel.released, &parallel.lock);
+    if (parallel.stop || parallel.next == parallel.total)
+      break;
+    size_t i = parallel.next++;
+    struct chunk *chunk = parallel.chunks + i % parallel.ring;
+    pthread_mutex_unlock (&parallel.lock);
+    if (parallel.binary) {
+      const struct frame_header *frame_header = parallel.frames.begin + i;
+      chunk->begin = frame_header->begin;
+      chunk->end = frame_header->end;
+      tokenize_frame (chunk, frame_header);
+    } else {
+      chunk->begin = chunk_boundary (i);
+      chunk->end = chunk_boundary (i + 1);
+      tokenize_chunk (chunk);
+    }
+    pthread_mutex_lock (&parallel.lock);
+    chunk->parsed = true;
+    pthread_cond_broadcast (&parallel.parsed);
+  }
+  pthread_mutex_unlock (&parallel.lock);
+  return 0;
+}
+
+static inline size_t signed_varint_bytes (clause_id i) {
+  unsigned_clause_id abs_i = i < 0 ? -i : i;
+  unsigned_clause_id u = (i < 0) + 2 * abs_i;
+  size_t res = 1;
+  while (u > 127)
+    u >>= 7, res++;
+  return res;
+}
+
+// For frames the parser position 'input.bytes' is recomputed before each
+// check to match the position the sequential parser would have reached,
+// since binary parse errors refer to byte offsets instead of lines.
+
+static clause_id merge_chunk (struct chunk *chunk, size_t base,
+                              clause_id last_id) {
+  const bool binary = parallel.binary;
+  clause_id *p = chunk->records.begin, *end = chunk->records.end;
+  input.last = ' ';
+  while (p != end) {
+    size_t pos = base + *p++;
+    if (binary)
+      input.bytes = ++pos;
+    else
+      input.lines = pos;
+    const size_t info = pos + 1;
+    int type = *p++;
+    clause_id id = *p++;
+    if (binary) {
+      if (type == 'a')
+        input.bytes = pos += signed_varint_bytes (id);
+      else
+        id = last_id;
+    }
+    dbg ("parsed clause identifier %" PRIid " at %s %zu", id,
+         binary ? "byte" : "line", info);
+    if (id < last_id)
+      prr ("identifier '%" PRIid "' smaller than last '%" PRIid "'", id,
+           last_id);
+    ADJUST (clauses.status, id);
+    if (type == 'd') {
+      clause_id other;
+      while ((other = *p++)) {
+        if (binary)
+          input.bytes = pos += signed_varint_bytes (other);
+        delete_antecedent (other, binary, info);
+      }
+#if !defined(NDEBUG) || defined(LOGGING)
+      PUSH (parsed_antecedents, 0);
+      dbgids (parsed_antecedents.begin,
+              "parsed deletion and deleted clauses");
+      CLEAR (parsed_antecedents);
+#endif
+    } else {
+      assert (type == 'a');
+      check_addition (id, last_id);
+      assert (EMPTY (parsed_literals));
+      size_t offset = (chunk->begin - buffer.chars) + *p++;
+      int lit;
+      do {
+        lit = *p++;
+        if (binary && lit)
+          pos += signed_varint_bytes (lit);
+        PUSH (parsed_literals, lit);
+      } while (lit);
+      pos++;
+      dbgs (parsed_literals.begin, "clause %" PRIid " literals", id);
+      size_t size_literals = SIZE (parsed_literals);
+      check_literals (id, size_literals);
+      clause_id *antecedents = p, other;
+      while ((other = *p++)) {
+        if (binary)
+          input.bytes = pos += signed_varint_bytes (other);
+        check_antecedent (id, other, binary);
+      }
+      dbgids (antecedents, "clause %" PRIid " antecedents", id);
+      add_clause (id, parsed_literals.begin, size_literals, antecedents,
+                  p - antecedents, info, offset);
+      CLEAR (parsed_literals);
+    }
+    last_id = id;
+  }
+  return last_id;
+}
+
+// Starts the workers on 'parallel.total' chunks or frames and merges their
+// records in order until all are merged or one was not accepted, in which
+// case its start is saved as position 'parallel.resume' where sequential
+// parsing continues.
+
+static clause_id merge_in_parallel (clause_id last_id) {
+  parallel.next = parallel.merged = 0;
+  parallel.stop = false;
+  parallel.ring = 2 * (size_t)threads;
+  parallel.chunks = calloc (parallel.ring, sizeof *parallel.chunks);
+  parallel.workers = calloc (threads, sizeof *parallel.workers);
+  if (!parallel.chunks || !parallel.workers)
+    die ("out-of-memory allocating parallel parsing chunks");
+  for (int i = 0; i != threads; i++)
+    if (pthread_create (parallel.workers + i, 0, parse_chunks, 0))
+      die ("failed to start parsing thread for '%s'", input.path);
+  size_t lines = input.lines;
+  for (size_t i = 0; i != parallel.total; i++) {
+    struct chunk *chunk = parallel.chunks + i % parallel.ring;
+    pthread_mutex_lock (&parallel.lock);
+    while (!chunk->parsed)
+      pthread_cond_wait (&parallel.parsed, &parallel.lock);
+    pthread_mutex_unlock (&parallel.lock);
+    size_t base = lines;
+    if (parallel.binary)
+      base = parallel.offset + (chunk->begin - buffer.chars);
+    last_id = merge_chunk (chunk, base, last_id);
+    lines += chunk->lines;
+    if (chunk->stopped) {
+      parallel.resume = chunk->stopped;
+      break;
+    }
+    pthread_mutex_lock (&parallel.lock);
+    chunk->parsed = false;
+    parallel.merged++;
+    pthread_cond_broadcast (&parallel.released);
+    pthread_mutex_unlock (&parallel.lock);
+  }
+  pthread_mutex_lock (&parallel.lock);
+  parallel.stop = true;
+  pthread_cond_broadcast (&parallel.released);
+  pthread_mutex_unlock (&parallel.lock);
+  for (int i = 0; i != threads; i++)
+    if (pthread_join (parallel.workers[i], 0))
+      die ("failed to join parsing thread for '%s'", input.path);
+  for (size_t i = 0; i != parallel.ring; i++)
+    RELEASE (parallel.chunks[i].records);
+  free (parallel.chunks);
+  free (parallel.workers);
+  input.lines = lines;
+  input.bytes = parallel.offset + (parallel.resume - buffer.chars);
+  buffer.pos = parallel.resume - buffer.chars;
+  return last_id;
+}
+
+static clause_id parse_chunks_in_parallel (clause_id last_id) {
+  assert (parse_in_parallel || parallel.resume_line);
+  parse_in_parallel = false;
+  parallel.resume_line = 0;
+  if (!input.map || buffer.chars != input.map)
+    return last_id;
+  const unsigned char *begin = buffer.chars + buffer.pos;
+  const unsigned char *end = buffer.chars + buffer.end;
+  if (begin == end)
+    return last_id;
+  size_t size = (end - begin) / (4 * (size_t)threads);
+  if (size < min_chunk_size)
+    size = min_chunk_size;
+  if (size > max_chunk_size)
+    size = max_chunk_size;
+  parallel.binary = false;
+  parallel.begin = begin;
+  parallel.end = parallel.resume = end;
+  parallel.offset = input.bytes - buffer.pos;
+  parallel.size = size;
+  parallel.total = (end - begin + size - 1) / size;
+  vrb ("parsing %s of '%s' in %zu chunks with %d threads",
+       pretty_bytes (end - begin), input.path, parallel.total, threads);
+  last_id = merge_in_parallel (last_id);
+  input.last = '\n';
+  if (parallel.resume != end) {
+    vrb ("continuing sequential parsing at line %zu", input.lines + 1);
+    if (parallel.sequential_lines)
+      parallel.sequential_lines *= 2;
+    else
+      parallel.sequential_lines = 1;
+    parallel.resume_line = input.lines + parallel.sequential_lines;
+  }
+  return last_id;
+}
+
+// Called with the frame header byte 'f' just read.  On return the frame
+// state is set up as if a frame ended at the resume position, where the
+// sequential parser then expects the next frame header or end-of-file.
+
+static clause_id parse_frames_in_parallel (clause_id last_id) {
+  assert (parse_in_parallel);
+  assert (input.map);
+  assert (buffer.chars == input.map);
+  assert (buffer.pos && buffer.chars[buffer.pos - 1] == 'f');
+  parse_in_parallel = false;
+  buffer.pos--;
+  input.bytes--;
+  const unsigned char *p = buffer.chars + buffer.pos;
+  const unsigned char *end = buffer.chars + buffer.end;
+  while (p != end && *p == 'f') {
+    struct frame_header frame_header;
+    frame_header.header = p++;
+    unsigned_clause_id bytes, first, clauses;
+    if (!(p = decode_varint (p, end, &bytes)) ||
+        !(p = decode_varint (p, end, &first)) || first > max_clause_id ||
+        !(p = decode_varint (p, end, &clauses)) || clauses > UINT_MAX ||
+        bytes > INT_MAX || bytes > (size_t)(end - p))
+      break;
+    frame_header.begin = p;
+    frame_header.end = p += bytes;
+    frame_header.first = first;
+    frame_header.clauses = clauses;
+    PUSH (parallel.frames, frame_header);
+  }
+  parallel.binary = true;
+  parallel.offset = input.bytes - buffer.pos;
+  parallel.total = SIZE (parallel.frames);
+  parallel.resume = parallel.total ? parallel.frames.end[-1].end
+                                   : buffer.chars + buffer.pos;
+  vrb ("parsing %zu frames of '%s' with %d threads", parallel.total,
+       input.path, threads);
+  last_id = merge_in_parallel (last_id);
+  RELEASE (parallel.frames);
+  frame.open = true;
+  frame.end = input.bytes;
+  frame.clauses = frame.added = 0;
+  if (parallel.resume != end)
+    vrb ("continuing sequential parsing at byte %zu", input.bytes);
+  return last_id;
+}
+
+#endif
+
 static void parse_proof () {
   double start = process_time ();
   vrb ("starting parsing proof after %.2f seconds", start);
   assert (proof.input);
   input = *proof.input;
   msg ("reading proof from '%s'", input.path);
+  start_reading ();
 
   int ch = read_first_char ();
   while (ch == 'c' || ch == 's' || ch == 'v') {
     read_until_new_line ();
     ch = read_ascii ();
   }
-  if (ch == 'a' || ch == 'd') {
+  if (ch == 'a' || ch == 'd' || ch == 'f') {
     vrb ("first character '%c' indicates binary proof format", ch);
     input.binary = true;
   } else if (ISDIGIT (ch)) {
@@ -1372,7 +3548,14 @@ static void parse_proof () {
 
   const bool binary = input.binary;
 
-  int last_id = 0;
+#ifndef NTHREADS
+  if (threads > 1 && input.map)
+    parse_in_parallel = true;
+  if (threads > 1 && checking && forward)
+    start_pipeline ();
+#endif
+
+  clause_id last_id = 0;
 
   while (ch != EOF) {
 
@@ -1383,94 +3566,141 @@ static void parse_proof () {
     }
 
     const size_t info = (binary ? input.bytes : input.lines) + 1;
-    int id, type = 0;
+    clause_id id;
+    int type = 0;
 
     if (binary) {
+      if (frame.open) {
+        size_t start = input.bytes - 1;
+        if (start > frame.end)
+          prr ("proof line crosses end of frame at byte %zu", frame.end);
+        if (start == frame.end) {
+          close_frame ();
+          if (ch != 'f')
+            prr ("expected frame header 'f' at end of frame");
+        }
+      }
+      if (ch == 'f') {
+#ifndef NTHREADS
+        if (parse_in_parallel && buffer.chars == input.map)
+          last_id = parse_frames_in_parallel (last_id);
+        else
+#endif
+          read_frame_header ();
+        ch = read_binary ();
+        continue;
+      }
       if (ch != 'a' && ch != 'd')
         prr ("expected either 'a' or 'd'");
       type = ch;
       if (ch == 'a') {
-        ch = read_binary ();
-        if (ch == EOF)
-          prr ("end-of-file after '%c'", type);
-        if (!ch)
-          prr ("invalid zero clause identifier '0' in addition");
-        unsigned uid = 0, shift = 0;
-        for (;;) {
-          unsigned uch = ch;
-          if (shift == 28 && (uch & ~15u))
-            prr ("excessive clause identifier");
-          uid |= (uch & 127) << shift;
-          if (!(uch & 128))
-            break;
-          shift += 7;
+        unsigned_clause_id uid;
+        unsigned peeked, bytes = peek_varint (&peeked);
+        if (bytes && peeked) {
+          skip_varint (bytes);
+          uid = peeked;
+        } else {
           ch = read_binary ();
-          if (!ch)
-            prr ("invalid zero byte in clause identifier");
           if (ch == EOF)
-            prr ("end-of-file parsing clause identifier");
+            prr ("end-of-file after '%c'", type);
+          if (!ch)
+            prr ("invalid zero clause identifier '0' in addition");
+          unsigned shift = 0;
+          uid = 0;
+          for (;;) {
+            unsigned uch = ch;
+            if (excessive_clause_id_byte (shift, uch))
+              prr ("excessive clause identifier");
+            uid |= (unsigned_clause_id)(uch & 127) << shift;
+            if (!(uch & 128))
+              break;
+            shift += 7;
+            ch = read_binary ();
+            if (!ch)
+              prr ("invalid zero byte in clause identifier");
+            if (ch == EOF)
+              prr ("end-of-file parsing clause identifier");
+          }
         }
         if (uid & 1)
           prr ("negative identifier in clause addition");
         uid >>= 1;
-        if (uid > (unsigned)INT_MAX)
-          prr ("clause identifier %u too large", uid);
+        if (uid > (unsigned_clause_id)max_clause_id)
+          prr ("clause identifier %" PRIuid " too large", uid);
         id = uid;
-        dbg ("parsed clause identifier %d at byte %zu", id, info);
+        dbg ("parsed clause identifier %" PRIid " at byte %zu", id, info);
+        if (frame.open && !frame.added++ && id != frame.first)
+          prr ("first added clause %" PRIid " in frame "
+               "differs from %" PRIid " in header",
+               id, frame.first);
       } else
         id = last_id;
     } else { // !binary
       if (!ISDIGIT (ch))
         prr ("expected digit as first character of line");
       id = ch - '0';
+      if (id)
+        id = read_more_digits (id);
       while (ISDIGIT (ch = read_ascii ())) {
         if (!id)
           prr ("unexpected digit '%c' after '0'", ch);
-        if (INT_MAX / 10 < id)
+        if (max_clause_id / 10 < id)
         LINE_IDENTIFIER_EXCEEDS_INT_MAX:
-          prr ("line identifier '%s' exceeds 'INT_MAX'",
+          prr ("line identifier '%s' exceeds '" max_clause_id_name "'",
                exceeds_int_max (id, ch));
         id *= 10;
         int digit = ch - '0';
-        if (INT_MAX - digit < id) {
+        if (max_clause_id - digit < id) {
           id /= 10;
           goto LINE_IDENTIFIER_EXCEEDS_INT_MAX;
         }
         id += digit;
       }
       if (ch != ' ')
-        prr ("expected space after identifier '%d'", id);
-      dbg ("parsed clause identifier %d at line %zu", id, info);
+        prr ("expected space after identifier '%" PRIid "'", id);
+      dbg ("parsed clause identifier %" PRIid " at line %zu", id, info);
       ch = read_ascii ();
       if (ch == 'd') {
         ch = read_ascii ();
         if (ch != ' ')
-          prr ("expected space after '%d d'", id);
+          prr ("expected space after '%" PRIid " d'", id);
         type = 'd';
       } else
         type = 'a';
     }
     if (id < last_id)
-      prr ("identifier '%d' smaller than last '%d'", id, last_id);
+      prr ("identifier '%" PRIid "' smaller than last '%" PRIid "'", id,
+           last_id);
     ADJUST (clauses.status, id);
     if (type == 'd') {
       assert (EMPTY (parsed_antecedents));
-      int last = 0;
+      clause_id last = 0;
       if (binary) {
         do {
-          int other;
+          clause_id other;
+          unsigned_clause_id uother;
+          unsigned peeked, bytes = peek_varint (&peeked);
+          if (bytes && !(peeked & 1)) {
+            skip_varint (bytes);
+            other = (peeked >> 1);
+            if (other)
+              delete_antecedent (other, binary, info);
+            last = other;
+            continue;
+          }
           ch = read_binary ();
           if (ch == EOF)
             prr ("end-of-file before zero byte in deletion");
           if (ch & 1)
             prr ("invalid negative antecedent in deletion");
           if (ch) {
-            unsigned uother = 0, shift = 0;
+            unsigned shift = 0;
+            uother = 0;
             for (;;) {
               unsigned uch = ch;
-              if (shift == 28 && (uch & ~15u))
+              if (excessive_clause_id_byte (shift, uch))
                 prr ("excessive antecedent in deletion");
-              uother |= (uch & 127) << shift;
+              uother |= (unsigned_clause_id)(uch & 127) << shift;
               if (!(uch & 128))
                 break;
               shift += 7;
@@ -1489,25 +3719,28 @@ static void parse_proof () {
         } while (last);
       } else { // !binary
         do {
-          int other;
+          clause_id other;
           ch = read_ascii ();
           if (!ISDIGIT (ch)) {
             if (last)
-              prr ("expected digit after '%d ' in deletion", last);
+              prr ("expected digit after '%" PRIid " ' in deletion", last);
             else
-              prr ("expected digit after '%d d ' in deletion", id);
+              prr ("expected digit after '%" PRIid " d ' in deletion", id);
           }
           other = ch - '0';
+          if (other)
+            other = read_more_digits (other);
           while (ISDIGIT ((ch = read_ascii ()))) {
             if (!other)
               prr ("unexpected digit '%c' after '0' in deletion", ch);
-            if (INT_MAX / 10 < other)
+            if (max_clause_id / 10 < other)
             DELETED_CLAUSE_IDENTIFIER_EXCEEDS_INT_MAX:
-              prr ("deleted clause identifier '%s' exceeds 'INT_MAX'",
+              prr ("deleted clause identifier '%s' "
+                   "exceeds '" max_clause_id_name "'",
                    exceeds_int_max (other, ch));
             other *= 10;
             int digit = ch - '0';
-            if (INT_MAX - digit < other) {
+            if (max_clause_id - digit < other) {
               other /= 10;
               goto DELETED_CLAUSE_IDENTIFIER_EXCEEDS_INT_MAX;
             }
@@ -1515,10 +3748,10 @@ static void parse_proof () {
           }
           if (other) {
             if (ch != ' ')
-              prr ("expected space after '%d' in deletion", other);
+              prr ("expected space after '%" PRIid "' in deletion", other);
             if (id && other > id)
-              prr ("deleted clause '%d' "
-                   "larger than deletion identifier '%d'",
+              prr ("deleted clause '%" PRIid "' "
+                   "larger than deletion identifier '%" PRIid "'",
                    other, id);
           } else if (ch != '\n')
             prr ("expected new-line after '0' at end of deletion");
@@ -1529,74 +3762,59 @@ static void parse_proof () {
       }
 #if !defined(NDEBUG) || defined(LOGGING)
       PUSH (parsed_antecedents, 0);
-      dbgs (parsed_antecedents.begin,
-            "parsed deletion and deleted clauses");
+      dbgids (parsed_antecedents.begin,
+              "parsed deletion and deleted clauses");
       CLEAR (parsed_antecedents);
 #endif
     } else {
       assert (type == 'a'); // Adding a clause code starts here.
-      if (id == last_id)
-        prr ("line identifier '%d' of addition line does not increase", id);
-      if (!first_clause_added_in_proof) {
-        if (last_clause_added_in_cnf) {
-          if (last_clause_added_in_cnf == id)
-            prr ("first added clause %d in proof "
-                 "has same identifier as last original clause",
-                 id);
-          else if (last_clause_added_in_cnf > id)
-            prr ("first added clause %d in proof "
-                 "has smaller identifier as last original clause %d",
-                 id, last_clause_added_in_cnf);
-        }
-        vrb ("adding first clause %d in proof", id);
-        first_clause_added_in_proof = id;
-        if (!last_clause_added_in_cnf) {
-          signed char *begin = clauses.status.begin;
-          signed char *end = begin + id;
-          for (signed char *p = begin + 1; p != end; p++) {
-            signed char status = *p;
-            if (status)
-              assert (status < 0);
-            else
-              *p = 1;
-          }
-          assert (!statistics.original.cnf.added);
-          statistics.original.cnf.added = id - 1;
-        }
-      }
+      check_addition (id, last_id);
       assert (EMPTY (parsed_literals));
+      assert (!lazy_literals || buffer.chars == input.map);
+      const size_t offset = binary ? buffer.pos : buffer.pos - 1;
       if (binary) {
         for (;;) {
+          unsigned uidx, bytes = peek_varint (&uidx);
+          if (bytes) {
+            skip_varint (bytes);
+            if (!uidx) {
+              PUSH (parsed_literals, 0);
+              break;
+            }
+            goto DECODED_LITERAL;
+          }
           ch = read_binary ();
           if (ch == EOF)
             prr ("end-of-file before terminating "
-                 "zero byte in literals of clause %d",
+                 "zero byte in literals of clause %" PRIid,
                  id);
           if (!ch) {
             PUSH (parsed_literals, 0);
             break;
           }
-          unsigned uidx = 0, shift = 0;
+          unsigned shift = 0;
+          uidx = 0;
           for (;;) {
             unsigned uch = ch;
             if (shift == 28 && (uch & ~15u))
-              prr ("excessive literal in clause %d", id);
+              prr ("excessive literal in clause %" PRIid, id);
             uidx |= (uch & 127) << shift;
             if (!(uch & 128))
               break;
             shift += 7;
             ch = read_binary ();
             if (!ch)
-              prr ("invalid zero byte in literal of clause %d", id);
+              prr ("invalid zero byte in literal of clause %" PRIid, id);
             if (ch == EOF)
-              prr ("end-of-file parsing literal in clause %d", id);
+              prr ("end-of-file parsing literal in clause %" PRIid, id);
           }
+        DECODED_LITERAL:;
           int idx = (uidx >> 1);
           int lit = (uidx & 1) ? -idx : idx;
           PUSH (parsed_literals, lit);
         }
       } else { // !binary
-        int last = id;
+        clause_id last = id;
         assert (last);
         bool first = true;
         while (last) {
@@ -1607,28 +3825,34 @@ static void parse_proof () {
             ch = read_ascii ();
           if (ch == '-') {
             if (!ISDIGIT (ch = read_ascii ()))
-              prr ("expected digit after '%d -' in clause %d", last, id);
+              prr ("expected digit after '%" PRIid " -' in clause %" PRIid,
+                   last, id);
             if (ch == '0')
-              prr ("expected non-zero digit after '%d -'", last);
+              prr ("expected non-zero digit after '%" PRIid " -'", last);
             sign = -1;
           } else if (!ISDIGIT (ch))
-            prr ("expected literal or '0' after '%d ' in clause %d", last,
-                 id);
+            prr ("expected literal or '0' after '%" PRIid " ' "
+                 "in clause %" PRIid,
+                 last, id);
           else
             sign = 1;
           int idx = ch - '0';
+          if (idx)
+            idx = read_more_digits (idx);
           while (ISDIGIT (ch = read_ascii ())) {
             if (!idx)
-              prr ("unexpected second '%c' after '%d 0' in clause %d", ch,
-                   last, id);
+              prr ("unexpected second '%c' after '%" PRIid " 0' "
+                   "in clause %" PRIid,
+                   ch, last, id);
             if (INT_MAX / 10 < idx) {
             VARIABLE_INDEX_EXCEEDS_INT_MAX:
               if (sign < 0)
                 prr ("variable index in literal '-%s' "
-                     "exceeds 'INT_MAX' in clause %d",
+                     "exceeds 'INT_MAX' in clause %" PRIid,
                      exceeds_int_max (idx, ch), id);
               else
-                prr ("variable index '%s' exceeds 'INT_MAX' in clause %d",
+                prr ("variable index '%s' exceeds 'INT_MAX' "
+                     "in clause %" PRIid,
                      exceeds_int_max (idx, ch), id);
             }
             idx *= 10;
@@ -1642,205 +3866,178 @@ static void parse_proof () {
           int lit = sign * idx;
           if (ch != ' ') {
             if (idx)
-              prr ("expected space after literal '%d' in clause %d", lit,
-                   id);
+              prr ("expected space after literal '%d' in clause %" PRIid,
+                   lit, id);
             else
-              prr ("expected space after literals and '0' in clause %d",
+              prr ("expected space after literals and '0' "
+                   "in clause %" PRIid,
                    id);
           }
           PUSH (parsed_literals, lit);
           last = lit;
         }
       }
-      dbgs (parsed_literals.begin, "clause %d literals", id);
-
-      size_t size_literals = SIZE (parsed_literals);
-      size_t bytes_literals = size_literals * sizeof (int);
-      int *l = malloc (bytes_literals);
-      if (!l) {
-        assert (size_literals);
-        die ("out-of-memory allocating literals of size %zu clause %d",
-             size_literals - 1, id);
-      }
-      memcpy (l, parsed_literals.begin, bytes_literals);
-      ADJUST (clauses.literals, id);
-      ACCESS (clauses.literals, id) = l;
-      if (size_literals == 1) {
-        if (!empty_clause) {
-          vrb ("found empty clause %d", id);
-          statistics.clauses.checked.empty++;
-          empty_clause = id;
-        }
-      }
-
-      CLEAR (parsed_literals);
+      dbgs (parsed_literals.begin, "clause %" PRIid " literals", id);
+      check_literals (id, SIZE (parsed_literals));
       assert (EMPTY (parsed_antecedents));
 
       if (binary) {
         for (;;) {
+          unsigned_clause_id uother;
+          unsigned peeked, bytes = peek_varint (&peeked);
+          if (bytes) {
+            skip_varint (bytes);
+            if (!peeked) {
+              PUSH (parsed_antecedents, 0);
+              break;
+            }
+            uother = peeked;
+            goto DECODED_ANTECEDENT;
+          }
           ch = read_binary ();
           if (ch == EOF)
-            prr ("end-of-file instead of antecedent in clause %d", id);
+            prr ("end-of-file instead of antecedent in clause %" PRIid, id);
           if (!ch) {
             PUSH (parsed_antecedents, 0);
             break;
           }
-          unsigned uother = 0, shift = 0;
+          unsigned shift = 0;
+          uother = 0;
           for (;;) {
             unsigned uch = ch;
-            if (shift == 28 && (uch & ~15u))
-              prr ("excessive antecedent in clause %d", id);
-            uother |= (uch & 127) << shift;
+            if (excessive_clause_id_byte (shift, uch))
+              prr ("excessive antecedent in clause %" PRIid, id);
+            uother |= (unsigned_clause_id)(uch & 127) << shift;
             if (!(uch & 128))
               break;
             shift += 7;
             ch = read_binary ();
             if (!ch)
-              prr ("invalid zero byte in clause %d", id);
+              prr ("invalid zero byte in clause %" PRIid, id);
             if (ch == EOF)
-              prr ("end-of-file parsing antecedent in clause %d", id);
-          }
-          int other = (uother >> 1);
-          int signed_other = (uother & 1) ? -other : other;
-          if (other) {
-            if (other >= id)
-              prr ("antecedent '%d' in clause %d exceeds clause",
-                   signed_other, id);
-            signed char status = ACCESS (clauses.status, other);
-            if (!status)
-              prr ("antecedent '%d' in clause %d "
-                   "is neither an original clause nor has been added",
-                   signed_other, id);
-            else if (status < 0) {
-              if (track) {
-                size_t info = ACCESS (clauses.deleted, other);
-                assert (info);
-                prr ("antecedent %d in clause %d was deleted at %s %zu",
-                     signed_other, id, binary ? "byte" : "clause", info);
-              } else
-                prr ("antecedent %d in clause %d was deleted before "
-                     "(run with '--track' for more information)",
-                     other, id);
-            }
+              prr ("end-of-file parsing antecedent in clause %" PRIid, id);
           }
+        DECODED_ANTECEDENT:;
+          clause_id other = (uother >> 1);
+          clause_id signed_other = (uother & 1) ? -other : other;
+          if (other)
+            check_antecedent (id, signed_other, binary);
           PUSH (parsed_antecedents, signed_other);
         }
       } else { // !binary
-        int last = 0;
+        clause_id last = 0;
         assert (!last);
         do {
           int sign;
           if ((ch = read_ascii ()) == '-') {
             if (!ISDIGIT (ch = read_ascii ()))
-              prr ("expected digit after '%d -' in clause %d", last, id);
+              prr ("expected digit after '%" PRIid " -' in clause %" PRIid,
+                   last, id);
             if (ch == '0')
-              prr ("expected non-zero digit after '%d -'", last);
+              prr ("expected non-zero digit after '%" PRIid " -'", last);
             sign = -1;
           } else if (!ISDIGIT (ch))
-            prr ("expected clause identifier after '%d ' "
-                 "in clause %d",
+            prr ("expected clause identifier after '%" PRIid " ' "
+                 "in clause %" PRIid,
                  last, id);
           else
             sign = 1;
-          int other = ch - '0';
+          clause_id other = ch - '0';
+          if (other)
+            other = read_more_digits (other);
           while (ISDIGIT (ch = read_ascii ())) {
             if (!other)
-              prr ("unexpected second '%c' after '%d 0' in clause %d", ch,
-                   last, id);
-            if (INT_MAX / 10 < other) {
+              prr ("unexpected second '%c' after '%" PRIid " 0' "
+                   "in clause %" PRIid,
+                   ch, last, id);
+            if (max_clause_id / 10 < other) {
             ANTECEDENT_IDENTIFIER_EXCEEDS_INT_MAX:
               if (sign < 0)
-                prr ("antecedent '-%s' exceeds 'INT_MAX' in clause %d",
+                prr ("antecedent '-%s' exceeds '" max_clause_id_name "' "
+                     "in clause %" PRIid,
                      exceeds_int_max (other, ch), id);
               else
-                prr ("antecedent '%s' exceeds 'INT_MAX' in clause %d",
+                prr ("antecedent '%s' exceeds '" max_clause_id_name "' "
+                     "in clause %" PRIid,
                      exceeds_int_max (other, ch), id);
             }
             other *= 10;
             int digit = ch - '0';
-            if (INT_MAX - digit < other) {
+            if (max_clause_id - digit < other) {
               other /= 10;
               goto ANTECEDENT_IDENTIFIER_EXCEEDS_INT_MAX;
             }
             other += digit;
           }
-          int signed_other = sign * other;
+          clause_id signed_other = sign * other;
           if (other) {
             if (ch != ' ')
-              prr ("expected space after antecedent '%d' in clause %d",
+              prr ("expected space after antecedent '%" PRIid "' "
+                   "in clause %" PRIid,
                    signed_other, id);
-            if (other >= id)
-              prr ("antecedent '%d' in clause %d exceeds clause",
-                   signed_other, id);
-            signed char status = ACCESS (clauses.status, other);
-            if (!status)
-              prr ("antecedent '%d' in clause %d "
-                   "is neither an original clause nor has been added",
-                   signed_other, id);
-            else if (status < 0) {
-              if (track) {
-                size_t info = ACCESS (clauses.deleted, other);
-                assert (info);
-                prr ("antecedent %d in clause %d was deleted at %s %zu",
-                     signed_other, id, binary ? "byte" : "clause", info);
-              } else
-                prr ("antecedent %d in clause %d was deleted before "
-                     "(run with '--track' for more information)",
-                     other, id);
-            }
+            check_antecedent (id, signed_other, binary);
           } else {
             if (ch != '\n')
-              prr ("expected new-line after '0' at end of clause %d", id);
+              prr ("expected new-line after '0' at end of clause %" PRIid,
+                   id);
           }
           PUSH (parsed_antecedents, signed_other);
           last = signed_other;
         } while (last);
       }
-      dbgs (parsed_antecedents.begin, "clause %d antecedents", id);
-      size_t size_antecedents = SIZE (parsed_antecedents);
-      assert (size_antecedents > 0);
-      if (track) {
-        ADJUST (clauses.added, id);
-        size_t *addition = &ACCESS (clauses.added, id);
-        *addition = info;
-      }
-      statistics.original.proof.added++;
-      if (checking && forward) {
-        check_clause (id, l, parsed_antecedents.begin);
-        dbg ("forward checked clause %d", id);
-      } else if (trimming || checking) {
-        size_t bytes_antecedents = size_antecedents * sizeof (int);
-        int *a = malloc (bytes_antecedents);
-        if (!a) {
-          assert (size_antecedents);
-          die ("out-of-memory allocating antecedents of size %zu clause "
-               "%d",
-               size_antecedents - 1, id);
-        }
-        memcpy (a, parsed_antecedents.begin, bytes_antecedents);
-        ADJUST (clauses.antecedents, id);
-        ACCESS (clauses.antecedents, id) = a;
-      }
+      dbgids (parsed_antecedents.begin, "clause %" PRIid " antecedents",
+              id);
+      add_clause (id, parsed_literals.begin, SIZE (parsed_literals),
+                  parsed_antecedents.begin, SIZE (parsed_antecedents), info,
+                  offset);
+      CLEAR (parsed_literals);
       CLEAR (parsed_antecedents);
-      ACCESS (clauses.status, id) = 1;
     }
     last_id = id;
   READ_NEXT_CH:
     if (binary) {
       ch = read_binary ();
       input.lines++;
-    } else
+    } else {
+#ifndef NTHREADS
+      if (parse_in_parallel ||
+          (parallel.resume_line && input.lines >= parallel.resume_line))
+        last_id = parse_chunks_in_parallel (last_id);
+#endif
       ch = read_ascii ();
+    }
   }
+  if (frame.open) {
+    if (input.bytes < frame.end)
+      prr ("end-of-file before end of frame at byte %zu", frame.end);
+    if (input.bytes > frame.end)
+      prr ("proof line crosses end of frame at byte %zu", frame.end);
+    close_frame ();
+  }
+#ifndef NTHREADS
+  finish_pipeline ();
+#endif
+  print_memory ("parsing proof");
   RELEASE (parsed_antecedents);
   RELEASE (parsed_literals);
-  if (input.close)
-    fclose (input.file);
+  ZERO (parsed_antecedents);
+  ZERO (parsed_literals);
+  stop_reading ();
   *proof.input = input;
 
-  RELEASE (clauses.deleted);
-  RELEASE (clauses.added);
-  RELEASE (clauses.status);
+  // Addition information is still needed for error messages in backward
+  // checking (see 'crr') and thus only released afterwards.
+
+  RELEASE_MAP (clauses.deleted);
+  RELEASE_MAP (clauses.status);
+  RELEASE_MAP (clauses.referenced);
+  ZERO (clauses.deleted);
+  ZERO (clauses.status);
+  ZERO (clauses.referenced);
+  if (!checking || forward) {
+    RELEASE_MAP (clauses.added);
+    ZERO (clauses.added);
+  }
 
   if (!empty_clause) {
     if (cnf.input)
@@ -1860,6 +4057,10 @@ static void parse_proof () {
   else
     vrb ("no clause deletions had to be ignored");
 
+  if (trimming)
+    vrb ("collected %zu deleted clauses never used as antecedent",
+         collected_clauses);
+
   double end = process_time (), duration = end - start;
   vrb ("finished parsing proof after %.2f seconds", end);
   msg ("parsing original proof took %.2f seconds and needed %.0f MB "
@@ -1867,15 +4068,61 @@ static void parse_proof () {
        duration, mega_bytes ());
 }
 
-static inline bool mark_used (int id, int used_where) {
+static inline bool mark_used (clause_id id, clause_id used_where) {
   assert (0 < id);
   assert (0 < used_where);
-  int *w = &ACCESS (clauses.used, id);
-  int used_before = *w;
+  clause_id *w = &ACCESS (clauses.used, id);
+  clause_id used_before = *w;
   if (used_before >= used_where)
     return true;
   *w = used_where;
-  dbg ("updated clause %d to be used in clause %d", id, used_where);
+  dbg ("updated clause %" PRIid " to be used in clause %" PRIid, id,
+       used_where);
+  if (used_before)
+    return true;
+  if (is_original_clause (id))
+    statistics.trimmed.cnf.added++;
+  else
+    statistics.trimmed.proof.added++;
+  return false;
+}
+
+#ifndef NTHREADS
+
+// With '--threads=<n>' the core is marked by '<n>' threads.  The clause in
+// which a clause is used is updated to the maximum with compare-and-swap
+// and thus ends up the same as in sequential marking, independent of the
+// order of traversal.  Only the thread which marks a clause first
+// traverses its antecedents.  Each thread traverses the antecedents
+// depth-first on its own stack and moves 'batch_marking' clauses to a
+// shared stack whenever other threads are idle.  Marking terminates as
+// soon as all threads are idle and the shared stack is empty.
+
+#define batch_marking 256
+
+static struct {
+  struct id_stack shared;
+  int idle;
+  bool done;
+  pthread_mutex_t lock;
+  pthread_cond_t work;
+} marking = {.lock = PTHREAD_MUTEX_INITIALIZER,
+             .work = PTHREAD_COND_INITIALIZER};
+
+static inline bool mark_used_atomically (clause_id id,
+                                         clause_id used_where) {
+  assert (0 < id);
+  assert (0 < used_where);
+  clause_id *w = &ACCESS (clauses.used, id);
+  clause_id used_before = __atomic_load_n (w, __ATOMIC_RELAXED);
+  do
+    if (used_before >= used_where)
+      return true;
+  while (!__atomic_compare_exchange_n (w, &used_before, used_where, true,
+                                       __ATOMIC_RELAXED,
+                                       __ATOMIC_RELAXED));
+  dbg ("updated clause %" PRIid " to be used in clause %" PRIid, id,
+       used_where);
   if (used_before)
     return true;
   if (is_original_clause (id))
@@ -1885,6 +4132,346 @@ static inline bool mark_used (int id, int used_where) {
   return false;
 }
 
+static void *mark_core (void *ptr) {
+  struct statistics *result = ptr;
+  struct id_stack work;
+  ZERO (work);
+  for (;;) {
+    if (EMPTY (work)) {
+      pthread_mutex_lock (&marking.lock);
+      __atomic_add_fetch (&marking.idle, 1, __ATOMIC_RELAXED);
+      while (!marking.done && EMPTY (marking.shared))
+        if (marking.idle == threads) {
+          marking.done = true;
+          pthread_cond_broadcast (&marking.work);
+        } else
+          pthread_cond_wait (&marking.work, &marking.lock);
+      if (marking.done) {
+        pthread_mutex_unlock (&marking.lock);
+        break;
+      }
+      __atomic_sub_fetch (&marking.idle, 1, __ATOMIC_RELAXED);
+      for (int i = 0; i != batch_marking && !EMPTY (marking.shared); i++)
+        PUSH (work, POP (marking.shared));
+      pthread_mutex_unlock (&marking.lock);
+    }
+    clause_id id = POP (work);
+    assert (ACCESS (clauses.used, id));
+    int *l = ACCESS (clauses.literals, id);
+    assert (l);
+    clause_id *a = unpack_antecedents (id, l);
+    for (clause_id *p = a, other; (other = *p); p++) {
+      if (other < 0)
+        other = -other;
+      if (!mark_used_atomically (other, id) && !is_original_clause (other))
+        PUSH (work, other);
+    }
+    if (SIZE (work) > batch_marking &&
+        __atomic_load_n (&marking.idle, __ATOMIC_RELAXED)) {
+      pthread_mutex_lock (&marking.lock);
+      for (int i = 0; i != batch_marking; i++)
+        PUSH (marking.shared, POP (work));
+      pthread_cond_broadcast (&marking.work);
+      pthread_mutex_unlock (&marking.lock);
+    }
+  }
+  *result = statistics;
+  RELEASE (work);
+  RELEASE (unpacked);
+  return 0;
+}
+
+static void mark_core_in_parallel (clause_id root) {
+  vrb ("marking core of clause %" PRIid " with %d threads", root,
+       threads);
+  marking.idle = 0;
+  marking.done = false;
+  PUSH (marking.shared, root);
+  pthread_t *workers = calloc (threads, sizeof *workers);
+  struct statistics *results = calloc (threads, sizeof *results);
+  if (!workers || !results)
+    die ("out-of-memory allocating marking threads");
+  for (int i = 0; i != threads; i++)
+    if (pthread_create (workers + i, 0, mark_core, results + i))
+      die ("failed to start marking thread");
+  for (int i = 0; i != threads; i++)
+    if (pthread_join (workers[i], 0))
+      die ("failed to join marking thread");
+  for (int i = 0; i != threads; i++) {
+    statistics.trimmed.cnf.added += results[i].trimmed.cnf.added;
+    statistics.trimmed.proof.added += results[i].trimmed.proof.added;
+  }
+  free (results);
+  free (workers);
+  RELEASE (marking.shared);
+  ZERO (marking.shared);
+}
+
+#endif
+
+// After trimming only the clauses in the core are needed for checking and
+// writing.  The records of these clauses are slid down in place into a
+// prefix of the sequence of arena chunks (first the chunks in memory and
+// then the spilled ones), following the same rule as 'allocate_ints' to
+// start a new chunk if a record does not fit.  The remaining chunks are
+// then released.  Sliding requires to move records in the order of their
+// position in this sequence.  As long as clauses are allocated in the
+// order of their identifiers and no freed clause was recycled (see
+// 'allocate_ints') this is the order of identifiers.  Otherwise, for
+// instance after collecting garbage clauses during parsing, the records
+// of core clauses are sorted by their position first.
+
+struct record {
+  size_t position;
+  clause_id id;
+};
+
+struct record_stack {
+  struct record *begin, *end, *allocated;
+};
+
+struct chunk_base {
+  const int *begin;
+  size_t index;
+};
+
+static int *arena_chunk (size_t i) {
+  size_t in_memory = SIZE (arena.chunks);
+  if (i < in_memory)
+    return arena.chunks.begin[i];
+  return arena.spilled.begin[i - in_memory];
+}
+
+static int cmp_chunk_bases (const void *p, const void *q) {
+  const int *a = ((const struct chunk_base *)p)->begin;
+  const int *b = ((const struct chunk_base *)q)->begin;
+  return (a > b) - (a < b);
+}
+
+static int cmp_records (const void *p, const void *q) {
+  size_t a = ((const struct record *)p)->position;
+  size_t b = ((const struct record *)q)->position;
+  return (a > b) - (a < b);
+}
+
+static size_t record_position (struct chunk_base *bases, size_t size,
+                               const int *record) {
+  size_t l = 0, r = size;
+  while (r - l > 1) {
+    size_t m = l + (r - l) / 2;
+    if (bases[m].begin <= record)
+      l = m;
+    else
+      r = m;
+  }
+  assert (bases[l].begin <= record);
+  assert (record < bases[l].begin + size_arena_chunk);
+  return bases[l].index * size_arena_chunk + (record - bases[l].begin);
+}
+
+static void compact_clauses () {
+  if (!empty_clause)
+    return;
+  size_t chunk_bytes = size_arena_chunk * sizeof (int);
+  size_t before = SIZE (arena.chunks) + SIZE (arena.spilled);
+  if (!before)
+    return;
+  struct chunk_base *bases = 0;
+  if (arena.unordered) {
+    vrb ("sorting unordered clauses before compaction");
+    if (!(bases = malloc (before * sizeof *bases)))
+      die ("out-of-memory allocating chunk bases");
+    for (size_t i = 0; i != before; i++)
+      bases[i].begin = arena_chunk (i), bases[i].index = i;
+    qsort (bases, before, sizeof *bases, cmp_chunk_bases);
+  }
+  struct record_stack records;
+  ZERO (records);
+  int **literals = clauses.literals.begin;
+  size_t size_literals = end_of_records ();
+  for (size_t id = next_record (0); id < size_literals;
+       id = next_record (id)) {
+    int *l = literals[id];
+    if (!l)
+      continue;
+    bool keep = id <= (size_t)empty_clause && ACCESS (clauses.used, id);
+    size_t size = keep ? clause_size (l) : forget_clause (l);
+    if (size > max_arena_size) {
+      if (!keep) {
+        free (l - 1);
+        literals[id] = 0;
+      }
+      continue;
+    }
+    if (!keep) {
+      literals[id] = 0;
+      continue;
+    }
+    size_t position = bases ? record_position (bases, before, l - 1) : 0;
+    PUSH (records, ((struct record){position, id}));
+  }
+  if (bases) {
+    qsort (records.begin, SIZE (records), sizeof *records.begin,
+           cmp_records);
+    free (bases);
+  }
+  size_t chunks = 0;
+  int *dst = arena_chunk (0);
+  int *end = dst + size_arena_chunk;
+  for (struct record *p = records.begin; p != records.end; p++) {
+    clause_id id = p->id;
+    int *l = literals[id];
+    size_t size = clause_size (l);
+    size_t rounded = (size + 1) & ~(size_t)1;
+    if ((size_t)(end - dst) < rounded) {
+      dst = arena_chunk (++chunks);
+      end = dst + size_arena_chunk;
+    }
+    int *src = l - 1;
+    if (dst != src)
+      memmove (dst, src, size * sizeof (int));
+    literals[id] = dst + 1;
+    dst += rounded;
+  }
+  RELEASE (records);
+  arena.pos = dst;
+  arena.end = end;
+  memset (arena.free, 0, sizeof arena.free);
+  arena.unordered = false;
+  size_t after = chunks + 1;
+  while (SIZE (arena.chunks) + SIZE (arena.spilled) > after) {
+    if (!EMPTY (arena.spilled))
+      munmap (POP (arena.spilled), chunk_bytes);
+    else
+      free (POP (arena.chunks));
+  }
+  if (spill.path) {
+    size_t bytes = SIZE (arena.spilled) * chunk_bytes;
+    if (ftruncate (spill.fd, bytes))
+      die ("can not truncate temporary file '%s' to %zu bytes", spill.path,
+           bytes);
+  }
+  vrb ("compacted clauses from %s to %s",
+       pretty_bytes (before * chunk_bytes),
+       pretty_bytes (after * chunk_bytes));
+}
+
+// Decodes the literals of a lazy clause from the mapped input file, which
+// has already been parsed and checked and thus is trusted here.  Literals
+// of CNF clauses might be separated by comments and new-lines.
+
+static void decode_literals (struct file *file, size_t offset,
+                             struct int_stack *literals) {
+  assert (file->map);
+  assert (offset < file->size);
+  const unsigned char *p = file->map + offset;
+  const unsigned char *end = file->map + file->size;
+  CLEAR (*literals);
+  int lit;
+  if (file->binary) {
+    do {
+      unsigned uidx = 0, shift = 0, uch;
+      do {
+        assert (p != end);
+        uch = *p++;
+        uidx |= (uch & 127) << shift;
+        shift += 7;
+      } while (uch & 128);
+      int idx = uidx >> 1;
+      lit = (uidx & 1) ? -idx : idx;
+      PUSH (*literals, lit);
+    } while (lit);
+  } else {
+    do {
+      int ch;
+      while ((ch = *p) == ' ' || ch == '\t' || ch == '\n' || ch == '\r' ||
+             ch == 'c')
+        if (ch == 'c')
+          while (*p != '\n')
+            p++;
+        else
+          p++;
+      int sign = 1;
+      if (*p == '-')
+        sign = -1, p++;
+      int idx = 0;
+      while (p != end && ISDIGIT (*p))
+        idx = 10 * idx + (*p++ - '0');
+      lit = sign * idx;
+      PUSH (*literals, lit);
+    } while (lit);
+  }
+}
+
+// Replaces the lazy records of clauses in the core by records with their
+// decoded literals, which are allocated in a fresh arena, while all the
+// other clauses are dropped.  Then the chunks of the old arena are
+// released as a whole and the input files are unmapped.  The fresh arena
+// spills to a new temporary file, which allows to close the old one and
+// thus give its disk space back after unmapping the old spilled chunks.
+
+static void materialize_clauses () {
+  assert (lazy_literals);
+  size_t size_literals = end_of_records ();
+  struct ints_stack chunks = arena.chunks, spilled = arena.spilled;
+  char *spill_path = spill.path;
+  int spill_fd = spill.fd;
+  spill.path = 0;
+  spill.chunks = 0;
+  ZERO (arena.chunks);
+  ZERO (arena.spilled);
+  memset (arena.free, 0, sizeof arena.free);
+  arena.pos = arena.end = 0;
+  arena.literals = arena.antecedents = 0;
+  arena.unordered = false;
+  arena.last = 0;
+  struct int_stack decoded;
+  ZERO (decoded);
+  size_t materialized = 0;
+  int **literals = clauses.literals.begin;
+  for (size_t id = next_record (0); id < size_literals;
+       id = next_record (id)) {
+    int *l = literals[id];
+    if (!l)
+      continue;
+    bool large = clause_size (l) > max_arena_size;
+    if (id <= (size_t)empty_clause && ACCESS (clauses.used, id)) {
+      struct file *file = proof.input;
+      if (cnf.input && (clause_id)id <= last_clause_added_in_cnf)
+        file = cnf.input;
+      decode_literals (file, lazy_offset (l), &decoded);
+      dbgs (decoded.begin, "materialized clause %zu", id);
+      clause_id *a = unpack_antecedents (id, l);
+      size_t size_antecedents = 0;
+      if (*a)
+        while (a[size_antecedents++])
+          ;
+      new_clause (id, decoded.begin, SIZE (decoded), a, size_antecedents);
+      materialized++;
+    } else
+      literals[id] = 0;
+    if (large)
+      free (l - 1);
+  }
+  RELEASE (decoded);
+  for (int **p = chunks.begin; p != chunks.end; p++)
+    free (*p);
+  RELEASE (chunks);
+  size_t bytes = size_arena_chunk * sizeof (int);
+  for (int **p = spilled.begin; p != spilled.end; p++)
+    munmap (*p, bytes);
+  RELEASE (spilled);
+  if (spill_path) {
+    vrb ("releasing temporary file '%s'", spill_path);
+    close (spill_fd);
+    free (spill_path);
+  }
+  if (cnf.input)
+    unmap_file (cnf.input);
+  unmap_file (proof.input);
+  vrb ("materialized literals of %zu core clauses", materialized);
+}
+
 static void trim_proof () {
 
   if (!trimming)
@@ -1895,23 +4482,33 @@ static void trim_proof () {
 
   ADJUST (clauses.used, empty_clause);
 
-  static struct int_stack work;
+  static struct id_stack work;
   ZERO (work);
 
   if (empty_clause) {
     assert (EMPTY (work));
     mark_used (empty_clause, empty_clause);
+#ifndef NTHREADS
+    if (threads > 1) {
+      if (!is_original_clause (empty_clause))
+        mark_core_in_parallel (empty_clause);
+    } else
+#endif
     if (!is_original_clause (empty_clause))
       PUSH (work, empty_clause);
 
     while (!EMPTY (work)) {
-      unsigned id = POP (work);
+      clause_id id = POP (work);
       assert (ACCESS (clauses.used, id));
-      int *a = ACCESS (clauses.antecedents, id);
-      assert (a);
-      for (int *p = a, other; (other = abs (*p)); p++)
+      int *l = ACCESS (clauses.literals, id);
+      assert (l);
+      clause_id *a = unpack_antecedents (id, l);
+      for (clause_id *p = a, other; (other = *p); p++) {
+        if (other < 0)
+          other = -other;
         if (!mark_used (other, id) && !is_original_clause (other))
           PUSH (work, other);
+      }
     }
   }
 
@@ -1927,11 +4524,229 @@ static void trim_proof () {
 
   RELEASE (work);
 
+  if (lazy_literals)
+    materialize_clauses ();
+  else
+    compact_clauses ();
+
   double end = process_time (), duration = end - start;
   vrb ("finished trimming after %.2f seconds", end);
   msg ("trimming proof took %.2f seconds", duration);
+  print_memory ("trimming");
+}
+
+// Backward checking is dominated by cache misses on the chain of dependent
+// loads from the slot of an antecedent in 'clauses.literals' to its record
+// and then to the values of its literals.  Therefore the clauses to be
+// checked next are prefetched in stages, while checking the current one.
+// The record of the clause three clauses ahead is prefetched, for the one
+// two clauses ahead the slots of its antecedents and for the next one the
+// records of its antecedents, which then all have had time to arrive in
+// the cache when needed.  Checking several clauses truly interleaved would
+// require a separate assignment for each of them.
+
+#define PREFETCH(ADDRESS) __builtin_prefetch (ADDRESS)
+
+static inline void prefetch_antecedent (clause_id other, bool record) {
+  if (other < 0)
+    other = -other;
+  int **slot = &ACCESS (clauses.literals, other);
+  if (record)
+    PREFETCH (*slot - 1);
+  else
+    PREFETCH (slot);
+}
+
+static void prefetch_antecedents (clause_id id, bool records) {
+  int *a = clause_antecedents (ACCESS (clauses.literals, id));
+  if (packed_antecedents) {
+    for (const unsigned char *p = (unsigned char *)a; *p;) {
+      unsigned_clause_id u = 0, ch;
+      unsigned shift = 0;
+      do {
+        ch = *p++;
+        u |= (ch & 127) << shift;
+        shift += 7;
+      } while (ch & 128);
+      prefetch_antecedent (id - (clause_id)(u >> 1), records);
+    }
+  } else
+    for (clause_id *p = (clause_id *)a, other; (other = *p); p++)
+      prefetch_antecedent (other, records);
+}
+
+// Returns the next clause after 'id' up to 'last' which needs to be
+// checked or zero if there is none, also if 'id' itself is zero.
+
+static clause_id next_to_check (clause_id id, clause_id last) {
+  if (id)
+    while (id < last) {
+      id++;
+      if (!trimming || ACCESS (clauses.used, id))
+        return id;
+    }
+  return 0;
+}
+
+// Checks the clauses from 'first' to 'last' which need to be checked.
+// Parallel checking stops early at clauses larger than 'failed'.
+
+#define prefetched_clauses 3
+
+static void check_clauses_in_range (clause_id first, clause_id last,
+                                    clause_id *failed) {
+  assert (0 < first && first <= last);
+  clause_id ahead[prefetched_clauses];
+  clause_id id = first;
+  if (trimming && !ACCESS (clauses.used, id))
+    id = next_to_check (id, last);
+  for (int i = 0; i != prefetched_clauses; i++)
+    ahead[i] = next_to_check (i ? ahead[i - 1] : id, last);
+  while (id) {
+    if (failed && id > __atomic_load_n (failed, __ATOMIC_RELAXED))
+      break;
+    if (ahead[2])
+      PREFETCH (ACCESS (clauses.literals, ahead[2]) - 1);
+    if (ahead[1])
+      prefetch_antecedents (ahead[1], false);
+    if (ahead[0])
+      prefetch_antecedents (ahead[0], true);
+    int *l = ACCESS (clauses.literals, id);
+    clause_id *a = unpack_antecedents (id, l);
+    dbgs (l, "checking clause %" PRIid " literals", id);
+    dbgids (a, "checking clause %" PRIid " antecedents", id);
+    check_clause (id, l, a, 0);
+    id = ahead[0];
+    for (int i = 0; i + 1 != prefetched_clauses; i++)
+      ahead[i] = ahead[i + 1];
+    ahead[prefetched_clauses - 1] = next_to_check (ahead[2], last);
+  }
+}
+
+#ifndef NTHREADS
+
+// With '--threads=<n>' backward checking is parallelized too.  Clauses
+// are only read while checking and all the state of the checker is thread
+// local.  Thus the range of clauses to check is split into consecutive
+// sub-ranges of clause identifiers, which the checking threads claim in
+// increasing order through an atomic counter.  A thread checking a clause
+// which fails records its identifier in 'backward.failed' unless a smaller
+// one has already been recorded and then all threads skip clauses with
+// larger identifiers.  The main thread finally checks the failed clause
+// with the smallest identifier again, which is the clause the sequential
+// checker would have failed on first, and thus produces the same error.
+
+#define max_checking_range 1024
+
+static struct {
+  clause_id next, last, range, failed;
+  size_t variables;
+  struct statistics *statistics;
+} backward;
+
+static void fail_checking (clause_id id) {
+  clause_id failed = __atomic_load_n (&backward.failed, __ATOMIC_RELAXED);
+  while (id < failed &&
+         !__atomic_compare_exchange_n (&backward.failed, &failed, id, false,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
+}
+
+// Claims the next range of clauses to check.  The counter is only moved up
+// to the last clause and then set to zero, since adding the range blindly
+// could overflow the counter if the last clause has an identifier close to
+// the maximum identifier.
+
+static bool claim_checking_range (clause_id *begin_ptr,
+                                  clause_id *end_ptr) {
+  clause_id begin = __atomic_load_n (&backward.next, __ATOMIC_RELAXED);
+  clause_id end, next;
+  do {
+    if (!begin ||
+        begin > __atomic_load_n (&backward.failed, __ATOMIC_RELAXED))
+      return false;
+    assert (begin <= backward.last);
+    end = backward.last;
+    if (end - begin >= backward.range)
+      end = begin + backward.range - 1;
+    next = end == backward.last ? 0 : end + 1;
+  } while (!__atomic_compare_exchange_n (&backward.next, &begin, next,
+                                         false, __ATOMIC_RELAXED,
+                                         __ATOMIC_RELAXED));
+  *begin_ptr = begin;
+  *end_ptr = end;
+  return true;
+}
+
+static void *check_clauses (void *ptr) {
+  struct statistics *result = ptr;
+  if (strict)
+    ADJUST (variables.marks, backward.variables);
+  else
+    ADJUST (variables.values, backward.variables);
+  jmp_buf jump;
+  checking_failed = &jump;
+  clause_id begin, end;
+  while (claim_checking_range (&begin, &end)) {
+    if (setjmp (jump)) {
+      fail_checking (failed_clause);
+      continue;
+    }
+    check_clauses_in_range (begin, end, &backward.failed);
+  }
+  checking_failed = 0;
+  *result = statistics;
+  RELEASE_MAP (variables.marks);
+  RELEASE_MAP (variables.values);
+  RELEASE (unpacked);
+  return 0;
 }
 
+// Returns the smallest identifier of a clause which failed to check or
+// zero if all clauses from 'first' to 'last' were checked successfully.
+
+static clause_id check_clauses_in_parallel (clause_id first,
+                                            clause_id last) {
+  vrb ("checking clauses %" PRIid " to %" PRIid " with %d threads", first,
+       last, threads);
+  assert (0 < first && first <= last);
+  backward.next = first;
+  backward.last = last;
+  backward.failed = max_clause_id;
+  backward.range = (last - first) / (16 * (clause_id)threads) + 1;
+  if (backward.range > max_checking_range)
+    backward.range = max_checking_range;
+  backward.variables = strict ? SIZE (variables.marks)
+                              : SIZE (variables.values);
+  if (backward.variables)
+    backward.variables--;
+  pthread_t *workers = calloc (threads, sizeof *workers);
+  backward.statistics = calloc (threads, sizeof *backward.statistics);
+  if (!workers || !backward.statistics)
+    die ("out-of-memory allocating checking threads");
+  for (int i = 0; i != threads; i++)
+    if (pthread_create (workers + i, 0, check_clauses,
+                        backward.statistics + i))
+      die ("failed to start checking thread");
+  for (int i = 0; i != threads; i++)
+    if (pthread_join (workers[i], 0))
+      die ("failed to join checking thread");
+  for (int i = 0; i != threads; i++) {
+    struct statistics *s = backward.statistics + i;
+    statistics.clauses.checked.total += s->clauses.checked.total;
+    statistics.clauses.checked.empty += s->clauses.checked.empty;
+    statistics.clauses.resolved += s->clauses.resolved;
+    statistics.clauses.vectorized += s->clauses.vectorized;
+    statistics.literals.assigned += s->literals.assigned;
+    statistics.literals.marked += s->literals.marked;
+  }
+  free (backward.statistics);
+  free (workers);
+  return backward.failed == max_clause_id ? 0 : backward.failed;
+}
+
+#endif
+
 static void check_proof () {
 
   if (!checking || forward || !empty_clause)
@@ -1944,23 +4759,141 @@ static void check_proof () {
   double start = process_time ();
   vrb ("starting backward checking after %.2f seconds", start);
 
-  int id = first_clause_added_in_proof;
-  for (;;) {
-    int where = trimming ? ACCESS (clauses.used, id) : -1;
-    if (where) {
-      int *l = ACCESS (clauses.literals, id);
-      int *a = ACCESS (clauses.antecedents, id);
-      dbgs (l, "checking clause %d literals", id);
-      dbgs (a, "checking clause %d antecedents", id);
-      check_clause (id, l, a);
+  clause_id id = first_clause_added_in_proof;
+#ifndef NTHREADS
+  if (threads > 1) {
+    clause_id failed = check_clauses_in_parallel (id, empty_clause);
+    if (failed) {
+      int *l = ACCESS (clauses.literals, failed);
+      check_clause (failed, l, unpack_antecedents (failed, l), 0);
+      assert (!"checking failed clause again should have failed");
     }
-    if (id++ == empty_clause)
-      break;
-  }
+  } else
+#endif
+    check_clauses_in_range (id, empty_clause, 0);
+
+  RELEASE_MAP (clauses.added);
+  ZERO (clauses.added);
 
   double end = process_time (), duration = end - start;
   vrb ("finished backward checking after %.2f seconds", end);
   msg ("backward checking proof took %.2f seconds", duration);
+  print_memory ("checking");
+}
+
+static bool has_suffix (const char *str, const char *suffix) {
+  size_t l = strlen (str), k = strlen (suffix);
+  return l >= k && !strcasecmp (str + l - k, suffix);
+}
+
+// Compressed input files are recognized by their magic bytes and then read
+// through a pipe from an external decompression process, which thus runs
+// concurrently to parsing (and the read-ahead thread).  For output files
+// the compression tool is determined by the suffix of the file.
+
+static struct {
+  const char *suffix;
+  const char *command;
+  int signature[8];
+} compressors[] = {
+    {".gz", "gzip", {0x1f, 0x8b, EOF}},
+    {".bz2", "bzip2", {'B', 'Z', 'h', EOF}},
+    {".xz", "xz", {0xfd, '7', 'z', 'X', 'Z', 0, EOF}},
+    {".lzma", "lzma", {0x5d, 0, 0, EOF}},
+    {".zst", "zstd", {0x28, 0xb5, 0x2f, 0xfd, EOF}},
+};
+
+#define num_compressors (sizeof compressors / sizeof *compressors)
+
+static bool match_signature (FILE *file, const int *signature) {
+  bool res = true;
+  for (const int *p = signature; res && *p != EOF; p++)
+    res = (getc (file) == *p);
+  rewind (file);
+  return res;
+}
+
+static bool has_compressed_suffix (const char *path) {
+  for (size_t i = 0; i != num_compressors; i++)
+    if (has_suffix (path, compressors[i].suffix))
+      return true;
+  return false;
+}
+
+// Opens a pipe to or from the command with the path as argument, which is
+// quoted for the shell (single quotes in the path need to be escaped).
+
+static FILE *open_pipe (const char *fmt, const char *command,
+                        const char *path, const char *mode) {
+  size_t len = strlen (path), quotes = 0;
+  for (const char *p = path; *p; p++)
+    quotes += (*p == '\'');
+  size_t size = strlen (fmt) + strlen (command) + len + 3 * quotes + 1;
+  char *cmd = malloc (size), *quoted = malloc (len + 3 * quotes + 1);
+  if (!cmd || !quoted)
+    die ("out-of-memory allocating command for '%s'", path);
+  char *q = quoted;
+  for (const char *p = path; *p; p++)
+    if (*p == '\'')
+      *q++ = '\'', *q++ = '\\', *q++ = '\'', *q++ = '\'';
+    else
+      *q++ = *p;
+  *q = 0;
+  snprintf (cmd, size, fmt, command, quoted);
+  FILE *res = popen (cmd, mode);
+  free (quoted);
+  free (cmd);
+  return res;
+}
+
+// Magic bytes are only matched for regular files, which can be rewound.
+// Otherwise, for instance for pipes, bytes read can not be read again and
+// thus only the first byte is peeked at and pushed back.  Decompressing
+// such files is not supported.
+
+static bool read_compressed (struct file *file) {
+  struct stat buf;
+  if (fstat (fileno (file->file), &buf) || !S_ISREG (buf.st_mode)) {
+    int ch = getc (file->file);
+    if (ch == EOF)
+      return false;
+    ungetc (ch, file->file);
+    for (size_t i = 0; i != num_compressors; i++)
+      if (ch == compressors[i].signature[0])
+        die ("can not decompress '%s' which is not a regular file",
+             file->path);
+    return false;
+  }
+  for (size_t i = 0; i != num_compressors; i++) {
+    if (!match_signature (file->file, compressors[i].signature))
+      continue;
+    fclose (file->file);
+    const char *command = compressors[i].command;
+    file->file = open_pipe ("%s -c -d '%s'", command, file->path, "r");
+    if (!file->file)
+      die ("can not decompress '%s' with '%s'", file->path, command);
+    file->close = 2;
+    return true;
+  }
+  return false;
+}
+
+// Output files with a compression suffix are written through a pipe to the
+// corresponding compression tool, which thus runs in a separate process fed
+// by the write buffer.
+
+static bool write_compressed (struct file *file) {
+  for (size_t i = 0; i != num_compressors; i++) {
+    if (!has_suffix (file->path, compressors[i].suffix))
+      continue;
+    const char *command = compressors[i].command;
+    file->file = open_pipe ("%s -c > '%s'", command, file->path, "w");
+    if (!file->file)
+      die ("can not compress '%s' with '%s'", file->path, command);
+    file->close = 2;
+    return true;
+  }
+  return false;
 }
 
 static struct file *write_file (struct file *file) {
@@ -1972,17 +4905,41 @@ static struct file *write_file (struct file *file) {
     file->file = stdout;
     file->path = "<stdout>";
     assert (!file->close);
-  } else if (!(file->file = fopen (file->path, "w")))
+  } else if (write_compressed (file))
+    assert (file->close == 2);
+  else if (!(file->file = fopen (file->path, "w")))
     die ("can not write '%s'", file->path);
   else
     file->close = 1;
   return file;
 }
 
-static int map_id (int id) {
-  assert (id != INT_MIN);
-  int abs_id = abs (id);
-  int res;
+// Called at the start and end of writing an output file.
+
+static void start_writing () {
+  write_buffer.pos = 0;
+#ifndef NTHREADS
+  if (output.file)
+    start_writing_behind ();
+#endif
+}
+
+static void stop_writing () {
+  flush_buffer ();
+#ifndef NTHREADS
+  if (behind.active)
+    stop_writing_behind ();
+#endif
+  if (output.close == 1)
+    fclose (output.file);
+  else if (output.close == 2 && pclose (output.file))
+    die ("compressing '%s' failed", output.path);
+}
+
+static clause_id map_id (clause_id id) {
+  assert (id != -max_clause_id - 1);
+  clause_id abs_id = id < 0 ? -id : id;
+  clause_id res;
   if (abs_id < first_clause_added_in_proof)
     res = id;
   else {
@@ -1993,6 +4950,74 @@ static int map_id (int id) {
   return res;
 }
 
+// Frames are closed after complete proof lines as soon they reach
+// 'size_frame' bytes.  Then the frame header is written followed by the
+// content of the frame buffer.  The bytes of the frame were already
+// accounted for in 'output.bytes' while writing them to the frame buffer.
+
+static void start_framing () {
+  assert (!framing.active);
+  assert (!framing.chars);
+  framing.size = 2 * size_frame;
+  framing.chars = malloc (framing.size);
+  if (!framing.chars)
+    die ("out-of-memory allocating frame buffer");
+  framing.saved = write_buffer;
+  write_buffer.chars = framing.chars;
+  write_buffer.pos = 0;
+  write_buffer.end = framing.size;
+  framing.clauses = 0;
+  framing.active = true;
+}
+
+static void write_frame () {
+  assert (framing.active);
+  size_t bytes = write_buffer.pos;
+  if (!bytes)
+    return;
+  if (bytes > UINT_MAX)
+    die ("frame of %zu bytes too large", bytes);
+  framing.active = false;
+  write_buffer = framing.saved;
+  write_binary ('f');
+  write_unsigned (bytes);
+  write_unsigned_id (framing.clauses ? framing.first : 0);
+  write_unsigned (framing.clauses);
+  const unsigned char *p = framing.chars;
+  while (bytes) {
+    if (write_buffer.pos == write_buffer.end)
+      flush_buffer ();
+    size_t available = write_buffer.end - write_buffer.pos;
+    size_t copy = bytes < available ? bytes : available;
+    memcpy (write_buffer.chars + write_buffer.pos, p, copy);
+    write_buffer.pos += copy;
+    bytes -= copy;
+    p += copy;
+  }
+  framing.saved = write_buffer;
+  write_buffer.chars = framing.chars;
+  write_buffer.pos = 0;
+  write_buffer.end = framing.size;
+  framing.clauses = 0;
+  framing.active = true;
+}
+
+static void frame_line (clause_id added) {
+  if (added && !framing.clauses++)
+    framing.first = added;
+  if (write_buffer.pos >= size_frame)
+    write_frame ();
+}
+
+static void stop_framing () {
+  write_frame ();
+  assert (framing.active);
+  framing.active = false;
+  write_buffer = framing.saved;
+  free (framing.chars);
+  framing.chars = 0;
+}
+
 static void write_non_empty_proof () {
 
   assert (output.path);
@@ -2001,8 +5026,17 @@ static void write_non_empty_proof () {
   ADJUST (clauses.links, empty_clause);
   ADJUST (clauses.heads, empty_clause);
 
-  for (int id = 1; id != first_clause_added_in_proof; id++) {
-    int where = ACCESS (clauses.used, id);
+  // If a CNF is given, identifiers between its last clause and the first
+  // clause added in the proof do not belong to any clause and thus do not
+  // have to be deleted.  Without CNF we can not distinguish them from the
+  // identifiers of original clauses and have to keep deleting them.
+
+  clause_id last_original = first_clause_added_in_proof - 1;
+  if (cnf.input)
+    last_original = last_clause_added_in_cnf;
+
+  for (clause_id id = 1; id <= last_original; id++) {
+    clause_id where = ACCESS (clauses.used, id);
     if (where) {
       assert (id < where);
       assert (!is_original_clause (where));
@@ -2011,16 +5045,16 @@ static void write_non_empty_proof () {
     } else {
       if (!statistics.trimmed.cnf.deleted) {
         if (ascii) {
-          write_int (first_clause_added_in_proof - 1);
+          write_id (first_clause_added_in_proof - 1);
           write_str (" d");
         } else
           write_binary ('d');
       }
       if (ascii) {
         write_space ();
-        write_int (id);
+        write_id (id);
       } else
-        write_signed (id);
+        write_signed_id (id);
       statistics.trimmed.cnf.deleted++;
     }
   }
@@ -2031,6 +5065,8 @@ static void write_non_empty_proof () {
     else {
       write_binary (0);
       output.lines++;
+      if (framed)
+        frame_line (0);
     }
 
     vrb ("deleting %zu original CNF clauses initially",
@@ -2039,11 +5075,11 @@ static void write_non_empty_proof () {
 
   ADJUST (clauses.map, empty_clause);
 
-  int id = first_clause_added_in_proof;
-  int mapped = id;
+  clause_id id = first_clause_added_in_proof;
+  clause_id mapped = id;
 
   for (;;) {
-    int where = ACCESS (clauses.used, id);
+    clause_id where = ACCESS (clauses.used, id);
     if (where) {
       if (id != empty_clause) {
         assert (id < where);
@@ -2052,10 +5088,10 @@ static void write_non_empty_proof () {
         ACCESS (clauses.map, id) = mapped;
       }
       if (ascii)
-        write_int (mapped);
+        write_id (mapped);
       else {
         write_binary ('a');
-        write_signed (mapped);
+        write_signed_id (mapped);
       }
       int *l = ACCESS (clauses.literals, id);
       assert (l);
@@ -2068,56 +5104,57 @@ static void write_non_empty_proof () {
           write_signed (*p);
         write_binary (0);
       }
-      int *a = ACCESS (clauses.antecedents, id);
-      assert (a);
+      clause_id *a = unpack_antecedents (id, l);
       if (ascii) {
-        for (const int *p = a; *p; p++) {
+        for (const clause_id *p = a; *p; p++) {
           write_space ();
-          int other = *p;
-          assert (abs (other) < id);
-          int mapped = map_id (other);
+          clause_id other = *p;
+          assert ((other < 0 ? -other : other) < id);
+          clause_id mapped = map_id (other);
           assert ((other < 0) == (mapped < 0));
-          write_int (mapped);
+          write_id (mapped);
         }
         write_str (" 0\n");
       } else {
-        for (const int *p = a; *p; p++) {
-          int other = *p;
-          assert (abs (other) < id);
-          int mapped = map_id (other);
+        for (const clause_id *p = a; *p; p++) {
+          clause_id other = *p;
+          assert ((other < 0 ? -other : other) < id);
+          clause_id mapped = map_id (other);
           assert ((other < 0) == (mapped < 0));
-          write_signed (mapped);
+          write_signed_id (mapped);
         }
         write_binary (0);
       }
-      int head = ACCESS (clauses.heads, id);
+      clause_id head = ACCESS (clauses.heads, id);
       if (head) {
         if (ascii) {
-          write_int (mapped);
+          write_id (mapped);
           write_str (" d");
-          for (int link = head, next; link; link = next) {
+          for (clause_id link = head, next; link; link = next) {
             if (is_original_clause (link))
               statistics.trimmed.cnf.deleted++;
             else
               statistics.trimmed.proof.deleted++;
             write_space ();
-            write_int (map_id (link));
+            write_id (map_id (link));
             next = ACCESS (clauses.links, link);
           }
           write_str (" 0\n");
         } else {
           write_binary ('d');
-          for (int link = head, next; link; link = next) {
+          for (clause_id link = head, next; link; link = next) {
             if (is_original_clause (link))
               statistics.trimmed.cnf.deleted++;
             else
               statistics.trimmed.proof.deleted++;
-            write_signed (map_id (link));
+            write_signed_id (map_id (link));
             next = ACCESS (clauses.links, link);
           }
           write_binary (0);
         }
       }
+      if (framed)
+        frame_line (mapped);
       mapped++;
     }
     if (id++ == empty_clause)
@@ -2136,18 +5173,20 @@ static void write_proof () {
   double start = process_time ();
   vrb ("starting writing proof after %.2f seconds", start);
 
-  buffer.pos = 0;
   output = *write_file (proof.output);
   msg ("writing proof to '%s'", output.path);
-  if (empty_clause)
+  start_writing ();
+  if (empty_clause) {
+    if (framed)
+      start_framing ();
     write_non_empty_proof ();
-  else
+    if (framed)
+      stop_framing ();
+  } else
     write_empty_proof ();
 
   assert (proof.output);
-  flush_buffer ();
-  if (output.close)
-    fclose (output.file);
+  stop_writing ();
   *proof.output = output;
 
   msg ("trimmed %s to %s %.0f%%", pretty_bytes (proof.input->bytes),
@@ -2157,9 +5196,10 @@ static void write_proof () {
   double end = process_time (), duration = end - start;
   vrb ("finished writing proof after %.2f seconds", end);
   msg ("writing proof took %.2f seconds", duration);
+  print_memory ("writing proof");
 }
 
-static void write_clause (int id) {
+static void write_clause (clause_id id) {
   int *l = ACCESS (clauses.literals, id);
   for (int *p = l, lit; (lit = *p); p++)
     write_int (*p), write_space ();
@@ -2171,9 +5211,9 @@ static void write_cnf () {
     return;
   double start = process_time ();
   vrb ("starting writing CNF after %.2f seconds", start);
-  buffer.pos = 0;
   output = *write_file (cnf.output);
   msg ("writing CNF to '%s'", output.path);
+  start_writing ();
 
   write_str ("p cnf ");
   write_int (variables.original);
@@ -2182,16 +5222,14 @@ static void write_cnf () {
   size_t count = 0;
   write_size_t (statistics.trimmed.cnf.added);
   write_ascii ('\n');
-  int id = 0;
+  clause_id id = 0;
   while (id++ != last_clause_added_in_cnf)
     if (id <= empty_clause && ACCESS (clauses.used, id))
       write_clause (id), count++;
   assert (count == statistics.trimmed.cnf.added);
   msg ("wrote %zu clauses to CNF", count);
 
-  flush_buffer ();
-  if (output.close)
-    fclose (output.file);
+  stop_writing ();
   *cnf.output = output;
 
   vrb ("wrote %zu proof lines of %s", output.lines,
@@ -2207,17 +5245,24 @@ static void write_cnf () {
 
 static void release () {
 #ifndef NDEBUG
-  RELEASE (clauses.heads);
-  RELEASE (clauses.links);
-  RELEASE (clauses.map);
-  RELEASE (clauses.used);
+  RELEASE_MAP (clauses.added);
+  RELEASE_MAP (clauses.heads);
+  RELEASE_MAP (clauses.links);
+  RELEASE_MAP (clauses.map);
+  RELEASE_MAP (clauses.used);
   if (strict)
-    RELEASE (variables.marks);
+    RELEASE_MAP (variables.marks);
   else
-    RELEASE (variables.values);
-  RELEASE (trail);
-  release_ints_map (&clauses.literals);
-  release_ints_map (&clauses.antecedents);
+    RELEASE_MAP (variables.values);
+  release_clauses ();
+  RELEASE (unpacked);
+  release_arena ();
+#ifndef NTHREADS
+  for (size_t i = 0; i != num_ahead_buffers; i++)
+    free (ahead.chars[i]);
+  for (size_t i = 1; i != num_behind_buffers; i++)
+    free (behind.chars[i]);
+#endif
 #endif
 }
 
@@ -2267,7 +5312,59 @@ static void options (int argc, char **argv) {
       notrim = arg;
     else if (!strcmp (arg, "--relax"))
       relax = true;
-    else if (!strcmp (arg, "-V") || !strcmp (arg, "--version"))
+    else if (!strcmp (arg, "--compact"))
+      compact = arg;
+    else if (!strcmp (arg, "--framed"))
+      framed = arg;
+    else if (!strncmp (arg, "--framed=", 9)) {
+      const char *p = arg + 9;
+      if (!ISDIGIT (*p))
+        die ("invalid frame size in '%s'", arg);
+      size_t size = 0;
+      while (ISDIGIT (*p)) {
+        unsigned digit = *p++ - '0';
+        if (((INT_MAX >> 10) - digit) / 10 < size)
+          die ("frame size in '%s' too large", arg);
+        size = 10 * size + digit;
+      }
+      if (*p || !size)
+        die ("invalid frame size in '%s'", arg);
+      size_frame = size << 10;
+      framed = arg;
+    }    else if (!strcmp (arg, "--lazy"))
+      lazy = arg;
+    else if (!strncmp (arg, "--memory=", 9)) {
+      const char *p = arg + 9;
+      if (!ISDIGIT (*p))
+        die ("invalid memory limit in '%s'", arg);
+      size_t limit = 0;
+      while (ISDIGIT (*p)) {
+        unsigned digit = *p++ - '0';
+        if (((SIZE_MAX >> 20) - digit) / 10 < limit)
+          die ("memory limit in '%s' too large", arg);
+        limit = 10 * limit + digit;
+      }
+      if (*p)
+        die ("invalid memory limit in '%s'", arg);
+      memory_limit = limit << 20;
+      memory = arg;
+    } else if (!strncmp (arg, "--threads=", 10)) {
+#ifndef NTHREADS
+      const char *p = arg + 10;
+      if (!ISDIGIT (*p))
+        die ("invalid number of threads in '%s'", arg);
+      threads = 0;
+      while (ISDIGIT (*p)) {
+        threads = 10 * threads + (*p++ - '0');
+        if (threads > max_threads)
+          die ("number of threads in '%s' exceeds '%d'", arg, max_threads);
+      }
+      if (*p || !threads)
+        die ("invalid number of threads in '%s'", arg);
+#else
+      die ("invalid option '%s' (build without thread support)", arg);
+#endif
+    } else if (!strcmp (arg, "-V") || !strcmp (arg, "--version"))
       fputs (version, stdout), fputc ('\n', stdout), exit (0);
     else if (arg[0] == '-' && arg[1])
       die ("invalid option '%s' (try '-h')", arg);
@@ -2284,6 +5381,9 @@ static void options (int argc, char **argv) {
   if (size_files > 2 && notrim)
     die ("can not write to '%s' with '%s'", files[2].path, notrim);
 
+  if (framed && ascii)
+    die ("can not combine '%s' and '%s'", ascii, framed);
+
   for (size_t i = 0; i + 1 != size_files; i++)
     if (strcmp (files[i].path, "-") && strcmp (files[i].path, "/dev/null"))
       for (size_t j = i + 1; j != size_files; j++)
@@ -2298,6 +5398,10 @@ static void options (int argc, char **argv) {
   if (size_files == 4 && !strcmp (files[2].path, "-") &&
       !strcmp (files[3].path, "-"))
     die ("can not use '<stdout>' for both last two output files");
+
+#ifdef SIMD
+  vectorized = __builtin_cpu_supports ("avx2");
+#endif
 }
 
 static struct file *read_file (struct file *file) {
@@ -2311,17 +5415,16 @@ static struct file *read_file (struct file *file) {
     assert (!file->close);
   } else if (!(file->file = fopen (file->path, "r")))
     die ("can not read '%s'", file->path);
+  else if (read_compressed (file))
+    assert (file->close == 2);
   else
     file->close = 1;
+  if (file->file)
+    map_file (file);
   file->saved = EOF;
   return file;
 }
 
-static bool has_suffix (const char *str, const char *suffix) {
-  size_t l = strlen (str), k = strlen (suffix);
-  return l >= k && !strcasecmp (str + l - k, suffix);
-}
-
 static bool looks_like_a_dimacs_file (const char *path) {
   assert (path);
   if (!strcmp (path, "-"))
@@ -2332,20 +5435,16 @@ static bool looks_like_a_dimacs_file (const char *path) {
     return true;
   if (has_suffix (path, ".dimacs"))
     return true;
-#if 0
-  if (has_suffix (path, ".cnf.gz"))
-    return true;
-  if (has_suffix (path, ".cnf.bz2"))
-    return true;
-  if (has_suffix (path, ".cnf.xz"))
-    return true;
-  if (has_suffix (path, ".dimacs.gz"))
-    return true;
-  if (has_suffix (path, ".dimacs.bz2"))
-    return true;
-  if (has_suffix (path, ".dimacs.xz"))
-    return true;
-#endif
+  for (size_t i = 0; i != num_compressors; i++) {
+    const char *suffix = compressors[i].suffix;
+    char cnf[16], dimacs[16];
+    snprintf (cnf, sizeof cnf, ".cnf%s", suffix);
+    snprintf (dimacs, sizeof dimacs, ".dimacs%s", suffix);
+    if (has_suffix (path, cnf) || has_suffix (path, dimacs))
+      return true;
+  }
+  if (has_compressed_suffix (path))
+    return false;
   FILE *file = fopen (path, "r");
   if (!file)
     return false;
@@ -2460,6 +5559,15 @@ static void open_input_files () {
 
   checking = !nocheck && cnf.input; // No checking without CNF for sure.
   trimming = !notrim && !forward;   // With the above restriction (*).
+
+  if (lazy) {
+    if (!trimming)
+      wrn ("using '%s' without trimming does not make sense", lazy);
+    else if (!proof.input->map || (cnf.input && !cnf.input->map))
+      wrn ("ignoring '%s' as not all input files can be mapped", lazy);
+    else
+      lazy_literals = true;
+  }
 }
 
 static void print_banner () {
@@ -2523,6 +5631,11 @@ static void print_statistics () {
          statistics.clauses.resolved,
          average (statistics.clauses.resolved,
                   statistics.clauses.checked.total));
+    if (statistics.clauses.vectorized)
+      vrb ("vectorized %zu antecedents %.0f%% of resolved clauses",
+           statistics.clauses.vectorized,
+           percent (statistics.clauses.vectorized,
+                    statistics.clauses.resolved));
     if (strict)
       msg ("marked %zu literals %.2f per checked clause",
            statistics.literals.marked,
@@ -2534,6 +5647,9 @@ static void print_statistics () {
            average (statistics.literals.assigned,
                     statistics.clauses.checked.total));
   }
+  if (spill.total)
+    msg ("spilled %s of clauses to temporary file",
+         pretty_bytes (spill.total * size_arena_chunk * sizeof (int)));
   msg ("maximum memory usage of %.0f MB", mega_bytes ());
   msg ("total time of %.2f seconds", t);
 }
@@ -7,12 +7,19 @@ die () {
 
 cd `dirname $0`
 
-rm -f *.err* *.log* *.lrat1
+rm -f *.err* *.log* *.lrat[123] add128crlf.lrat
 
 lrattrim=../../lrat-trim
 
 [ -f $lrattrim ] || die "could not find 'lrat-trim'"
 
+if $lrattrim -h | grep -q -- --threads
+then
+  threads=yes
+else
+  threads=no
+fi
+
 run () {
   name=$1
 
@@ -53,6 +60,63 @@ run () {
     echo "./lrat-trim test/check/$cnf test/check/$lrat -S # checking failed with exit status '$status' (expected '$expected')"
     exit 1
   fi
+
+  lrat1=$name.lrat1
+  log2=$name.log2
+  err2=$name.err2
+
+  $lrattrim --compact -a $cnf $lrat $lrat1 1>$log2 2>$err2
+  status=$?
+  if [ $status = $expected ]
+  then
+    echo "./lrat-trim --compact -a test/check/$cnf test/check/$lrat test/check/$lrat1 # compact checking succeeded with exit status '$status'"
+  else
+    echo "./lrat-trim --compact -a test/check/$cnf test/check/$lrat test/check/$lrat1 # compact checking failed with exit status '$status' (expected '$expected')"
+    exit 1
+  fi
+
+  lrat2=$name.lrat2
+  log5=$name.log5
+  err5=$name.err5
+
+  $lrattrim --lazy -a $cnf $lrat $lrat2 1>$log5 2>$err5
+  status=$?
+  if [ $status = $expected ] && cmp $lrat1 $lrat2 1>/dev/null 2>&1
+  then
+    echo "./lrat-trim --lazy -a test/check/$cnf test/check/$lrat test/check/$lrat2 # lazy checking succeeded with exit status '$status'"
+  else
+    echo "./lrat-trim --lazy -a test/check/$cnf test/check/$lrat test/check/$lrat2 # lazy checking failed with exit status '$status' (expected '$expected')"
+    exit 1
+  fi
+
+  if [ $threads = yes ]
+  then
+    log3=$name.log3
+    err3=$name.err3
+
+    $lrattrim --threads=3 $cnf $lrat 1>$log3 2>$err3
+    status=$?
+    if [ $status = $expected ]
+    then
+      echo "./lrat-trim --threads=3 test/check/$cnf test/check/$lrat # parallel checking succeeded with exit status '$status'"
+    else
+      echo "./lrat-trim --threads=3 test/check/$cnf test/check/$lrat # parallel checking failed with exit status '$status' (expected '$expected')"
+      exit 1
+    fi
+
+    log4=$name.log4
+    err4=$name.err4
+
+    $lrattrim --threads=3 -S $cnf $lrat 1>$log4 2>$err4
+    status=$?
+    if [ $status = $expected ]
+    then
+      echo "./lrat-trim --threads=3 -S test/check/$cnf test/check/$lrat # pipelined checking succeeded with exit status '$status'"
+    else
+      echo "./lrat-trim --threads=3 -S test/check/$cnf test/check/$lrat # pipelined checking failed with exit status '$status' (expected '$expected')"
+      exit 1
+    fi
+  fi
 }
 
 runs=0
@@ -69,6 +133,8 @@ logs=`ls *.log|wc -l`
 errs=`ls *.err|wc -l`
 err1s=`ls *.err1|wc -l`
 log1s=`ls *.log1|wc -l`
+err2s=`ls *.err2|wc -l`
+log2s=`ls *.log2|wc -l`
 
 [ $runs = $cnfs ] || die "found $runs runs in './run.sh' but $cnfs '.cnf' files"
 [ $runs = $lrats ] || die "found $runs runs in './run.sh' but $lrats '.lrat' files"
@@ -76,5 +142,71 @@ log1s=`ls *.log1|wc -l`
 [ $runs = $log1s ] || die "found $runs runs in './run.sh' but $log1s '.log1' files"
 [ $runs = $errs ] || die "found $runs runs in './run.sh' but $errs '.err' files"
 [ $runs = $err1s ] || die "found $runs runs in './run.sh' but $err1s '.err1' files"
+[ $runs = $log2s ] || die "found $runs runs in './run.sh' but $log2s '.log2' files"
+[ $runs = $err2s ] || die "found $runs runs in './run.sh' but $err2s '.err2' files"
+
+if [ $threads = yes ]
+then
+  err3s=`ls *.err3|wc -l`
+  log3s=`ls *.log3|wc -l`
+  [ $runs = $log3s ] || die "found $runs runs in './run.sh' but $log3s '.log3' files"
+  [ $runs = $err3s ] || die "found $runs runs in './run.sh' but $err3s '.err3' files"
+  err4s=`ls *.err4|wc -l`
+  log4s=`ls *.log4|wc -l`
+  [ $runs = $log4s ] || die "found $runs runs in './run.sh' but $log4s '.log4' files"
+  [ $runs = $err4s ] || die "found $runs runs in './run.sh' but $err4s '.err4' files"
+fi
+
+# Identifiers between the last CNF clause and the first proof clause are
+# not deleted in the trimmed proof if the CNF is given, but are without.
+
+$lrattrim -a full3gaps.cnf full3gaps.lrat full3gaps.lrat3 \
+  1>full3gaps.log6 2>full3gaps.err6
+status=$?
+if [ $status = 20 ] && ! grep -q ' d .* 9 ' full3gaps.lrat3
+then
+  echo "./lrat-trim -a test/check/full3gaps.cnf test/check/full3gaps.lrat test/check/full3gaps.lrat3 # gap not deleted as expected"
+else
+  echo "./lrat-trim -a test/check/full3gaps.cnf test/check/full3gaps.lrat test/check/full3gaps.lrat3 # gap unexpectedly deleted"
+  exit 1
+fi
+runs=`expr $runs + 1`
+
+$lrattrim -a full3gaps.lrat full3gaps.lrat3 \
+  1>full3gaps.log7 2>full3gaps.err7
+status=$?
+if [ $status = 0 ] && grep -q '^98 d 9 .* 98 0$' full3gaps.lrat3
+then
+  echo "./lrat-trim -a test/check/full3gaps.lrat test/check/full3gaps.lrat3 # gap deleted as expected"
+else
+  echo "./lrat-trim -a test/check/full3gaps.lrat test/check/full3gaps.lrat3 # gap unexpectedly not deleted"
+  exit 1
+fi
+runs=`expr $runs + 1`
+
+# Carriage-returns before new-lines have to be accepted by the parallel
+# tokenizer too, as otherwise the rest of the proof is parsed sequentially.
+
+if [ $threads = yes ]
+then
+  awk 'NR == 3 || NR == 9000 { printf "%s\r\n", $0; next } { print }' \
+    add128.lrat > add128crlf.lrat
+  $lrattrim -a add128.cnf add128crlf.lrat add128crlf.lrat1 \
+    1>add128crlf.log8 2>add128crlf.err8
+  $lrattrim -v --threads=3 -a add128.cnf add128crlf.lrat add128crlf.lrat2 \
+    1>add128crlf.log9 2>add128crlf.err9
+  status=$?
+  if [ $status = 20 ] && cmp add128crlf.lrat1 add128crlf.lrat2 && \
+     grep -q 'in [1-9][0-9]* chunks with 3 threads' add128crlf.log9 && \
+     ! grep -q 'continuing sequential parsing' add128crlf.log9
+  then
+    echo "./lrat-trim -v --threads=3 -a test/check/add128.cnf test/check/add128crlf.lrat test/check/add128crlf.lrat2 # parallel parsing of carriage-returns succeeded"
+  else
+    echo "./lrat-trim -v --threads=3 -a test/check/add128.cnf test/check/add128crlf.lrat test/check/add128crlf.lrat2 # parallel parsing of carriage-returns failed"
+    exit 1
+  fi
+  rm -f add128crlf.lrat
+  runs=`expr $runs + 1`
+fi
 
 echo "passed $runs checking tests in 'test/check/run.sh'"
@@ -13,6 +13,13 @@ lrattrim=../../lrat-trim
 
 [ -f $lrattrim ] || die "could not find 'lrat-trim'"
 
+if $lrattrim -h | grep -q -- --threads
+then
+  threads=yes
+else
+  threads=no
+fi
+
 run () {
 
   name=$1
@@ -24,7 +31,7 @@ run () {
 
   count=1
 
-  for opts in "" " -t" " -v" " -t -v"
+  for opts in "" " -t" " -v" " -t -v" " -S -t -v"
   do
 
     log=$name.log$count
@@ -44,6 +51,31 @@ run () {
     count=`expr $count + 1`
 
   done
+
+  # Parallel checking has to report the same error as sequential checking.
+
+  if [ $threads = yes ]
+  then
+    for opts in " -t -v" " -S -t -v"
+    do
+      log=$name.log$count
+      err=$name.err$count
+      seq=$name.err`expr $count - 2`
+
+      $lrattrim --threads=3$opts $cnf $lrat 1>$log 2>$err
+      status=$?
+
+      if [ $status = 1 ] && cmp $seq $err 1>/dev/null 2>&1
+      then
+        echo "./lrat-trim --threads=3$opts test/fail/$cnf test/fail/$lrat # parallel checking failed as expected"
+      else
+        echo "./lrat-trim --threads=3$opts test/fail/$cnf test/fail/$lrat # unexpected exit code $status or different error"
+        exit 1
+      fi
+
+      count=`expr $count + 1`
+    done
+  fi
 }
 
 run empty
@@ -54,6 +86,7 @@ run delnonexist2
 run deltwice
 run cidtoosmall1
 run cidtoosmall2
+run twofailures
 
 runs=`grep '^run [a-z]' run.sh|wc -l`
 
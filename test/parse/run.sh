@@ -13,6 +13,13 @@ lrattrim=../../lrat-trim
 
 [ -f $lrattrim ] || die "could not find 'lrat-trim'"
 
+if $lrattrim -h | grep -q -- --threads
+then
+  threads=yes
+else
+  threads=no
+fi
+
 runcnf () {
   name=$1
   cnf=$name.cnf
@@ -76,6 +83,23 @@ runlrat () {
     echo "./lrat-trim -t -v test/parse/$lrat # unexpected exit code $status"
     exit 1
   fi
+
+  # Parallel parsing has to report the same error as sequential parsing.
+
+  [ $threads = yes ] || return
+
+  log3=$name.log3
+  err3=$name.err3
+
+  $lrattrim --threads=4 $lrat 1>$log3 2>$err3
+  status=$?
+  if [ $status = 1 ] && cmp $err1 $err3 1>/dev/null 2>&1
+  then
+    echo "./lrat-trim --threads=4 test/parse/$lrat # parallel parsing failed as expected"
+  else
+    echo "./lrat-trim --threads=4 test/parse/$lrat # unexpected exit code $status or different error"
+    exit 1
+  fi
 }
 
 runlrit () {
@@ -109,6 +133,23 @@ runlrit () {
     echo "./lrat-trim -t -v test/parse/$lrit # unexpected exit code $status"
     exit 1
   fi
+
+  # Parallel parsing has to report the same error as sequential parsing.
+
+  [ $threads = yes ] || return
+
+  log3=$name.log3
+  err3=$name.err3
+
+  $lrattrim --threads=4 $lrit 1>$log3 2>$err3
+  status=$?
+  if [ $status = 1 ] && cmp $err1 $err3 1>/dev/null 2>&1
+  then
+    echo "./lrat-trim --threads=4 test/parse/$lrit # parallel parsing failed as expected"
+  else
+    echo "./lrat-trim --threads=4 test/parse/$lrit # unexpected exit code $status or different error"
+    exit 1
+  fi
 }
 
 runcnf clausemissing
@@ -196,18 +237,34 @@ runlrit invalidfirstbyte
 runlrit expectedaord
 runlrit eofaftera
 runlrit eofafterd
+
+# Clause identifiers larger than 'INT_MAX' are only accepted if compiled
+# with 64-bit clause identifiers ('configure --long-ids').
+
+skipped=0
+if grep -q LONGIDS ../../makefile 2>/dev/null
+then
+  echo "./lrat-trim test/parse/bincidtoolarge.lrit # skipped (64-bit identifiers)"
+  skipped=1
+else
 runlrit bincidtoolarge
+fi
+
 runlrit binzeroclauseid
 runlrit delzero
 runlrit addeof
 runlrit addexessiveante
 runlrit addzeroante
 runlrit addeofante
+runlrit framecount
+runlrit framecount2
+runlrit framecross
+runlrit framecross2
 
 lritruns=`grep '^runlrit [a-z]' run.sh|wc -l`
 lratruns=`grep '^runlrat [a-z]' run.sh|wc -l`
 cnfruns=`grep '^runcnf [a-z]' run.sh|wc -l`
-runs=`expr $lritruns + $lratruns + $cnfruns`
+runs=`expr $lritruns + $lratruns + $cnfruns - $skipped`
 
 cnfs=`ls *.cnf|wc -l`
 lrats=`ls *.lrat|wc -l`
@@ -7,12 +7,19 @@ die () {
 
 cd `dirname $0`
 
-rm -f *.err* *.log* *.lrat[12]
+rm -f *.err* *.log* *.lrat[1234] *.lrit[345]
 
 lrattrim=../../lrat-trim
 
 [ -f $lrattrim ] || die "could not find 'lrat-trim'"
 
+if $lrattrim -h | grep -q -- --threads
+then
+  threads=yes
+else
+  threads=no
+fi
+
 runascii () {
   name=$1
 
@@ -60,6 +67,37 @@ runascii () {
     exit 1
   fi
 
+  if [ $threads = yes ]
+  then
+    lrat3=${lrat}3
+    log3=${log}3
+    err3=${err}3
+
+    $lrattrim --threads=4 -a $lrat $lrat3 1>$log3 2>$err3
+    status=$?
+    if [ $status = 0 ] && cmp $lrat1 $lrat3 1>/dev/null 2>&1
+    then
+      echo "./lrat-trim --threads=4 -a test/trim/$lrat test/trim/$lrat3 # parallel trimming succeeded"
+    else
+      echo "./lrat-trim --threads=4 -a test/trim/$lrat test/trim/$lrat3 # parallel trimming failed"
+      exit 1
+    fi
+  fi
+
+  lrat4=${lrat}4
+  log4=${log}4
+  err4=${err}4
+
+  $lrattrim --lazy -a $lrat $lrat4 1>$log4 2>$err4
+  status=$?
+  if [ $status = 0 ] && cmp $lrat1 $lrat4 1>/dev/null 2>&1
+  then
+    echo "./lrat-trim --lazy -a test/trim/$lrat test/trim/$lrat4 # lazy trimming succeeded"
+  else
+    echo "./lrat-trim --lazy -a test/trim/$lrat test/trim/$lrat4 # lazy trimming failed"
+    exit 1
+  fi
+
   runs=`expr $runs + 1`
 }
 
@@ -110,6 +148,48 @@ runbinary () {
     exit 1
   fi
 
+  lrit3=${lrit}3
+  log3=${log}3
+  err3=${err}3
+
+  $lrattrim --framed $lrit $lrit3 1>$log3 2>$err3
+  status=$?
+  if [ $status = 0 ]
+  then
+    echo "./lrat-trim --framed test/trim/$lrit test/trim/$lrit3 # framed trimming succeeded"
+  else
+    echo "./lrat-trim --framed test/trim/$lrit test/trim/$lrit3 # framed trimming failed"
+    exit 1
+  fi
+
+  lrit4=${lrit}4
+  log4=${log}4
+  err4=${err}4
+
+  $lrattrim $lrit3 $lrit4 1>$log4 2>$err4
+  status=$?
+  if [ $status = 0 ] && cmp $lrit2 $lrit4 1>/dev/null 2>&1
+  then
+    echo "./lrat-trim test/trim/$lrit3 test/trim/$lrit4 # trimming framed succeeded"
+  else
+    echo "./lrat-trim test/trim/$lrit3 test/trim/$lrit4 # trimming framed failed"
+    exit 1
+  fi
+
+  lrit5=${lrit}5
+  log5=${log}5
+  err5=${err}5
+
+  $lrattrim --lazy $lrit $lrit5 1>$log5 2>$err5
+  status=$?
+  if [ $status = 0 ] && cmp $lrit1 $lrit5 1>/dev/null 2>&1
+  then
+    echo "./lrat-trim --lazy test/trim/$lrit test/trim/$lrit5 # lazy trimming succeeded"
+  else
+    echo "./lrat-trim --lazy test/trim/$lrit test/trim/$lrit5 # lazy trimming failed"
+    exit 1
+  fi
+
   runs=`expr $runs + 1`
 }
 
@@ -127,4 +207,44 @@ do
   runbinary $name
 done
 
+# Deleted clauses never used as antecedent are collected while parsing and
+# their memory is recycled, which should still allow to compact clauses.
+
+$lrattrim -v add128.lrat 1>add128.compact.log 2>add128.compact.err
+status=$?
+if [ $status = 0 ] && \
+   grep -q '^c collected [1-9][0-9]* deleted clauses' add128.compact.log && \
+   grep -q '^c compacted clauses' add128.compact.log
+then
+  echo "./lrat-trim -v test/trim/add128.lrat # compacting after collecting succeeded"
+else
+  echo "./lrat-trim -v test/trim/add128.lrat # compacting after collecting failed"
+  exit 1
+fi
+
+# With small frames the trimmed proof consists of many frames, which are
+# decoded in parallel with threads and have to give the same result.
+
+if [ $threads = yes ]
+then
+  $lrattrim --framed=4 add128.lrat add128frames.lrit3 \
+    1>add128frames.log3 2>add128frames.err3 || \
+  die "writing 'add128frames.lrit3' failed"
+  $lrattrim -a add128frames.lrit3 add128frames.lrat3 \
+    1>add128frames.log4 2>add128frames.err4 || \
+  die "sequential parsing of 'add128frames.lrit3' failed"
+  $lrattrim -v --threads=4 -a add128frames.lrit3 add128frames.lrat4 \
+    1>add128frames.log5 2>add128frames.err5
+  status=$?
+  if [ $status = 0 ] && cmp add128frames.lrat3 add128frames.lrat4 && \
+     grep -q 'parsing [1-9][0-9][0-9]* frames' add128frames.log5 && \
+     ! grep -q 'continuing sequential parsing' add128frames.log5
+  then
+    echo "./lrat-trim -v --threads=4 -a test/trim/add128frames.lrit3 test/trim/add128frames.lrat4 # parallel parsing of frames succeeded"
+  else
+    echo "./lrat-trim -v --threads=4 -a test/trim/add128frames.lrit3 test/trim/add128frames.lrat4 # parallel parsing of frames failed"
+    exit 1
+  fi
+fi
+
 echo "passed $runs trimming tests in 'test/trim/run.sh'"
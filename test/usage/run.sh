@@ -9,6 +9,7 @@ cd `dirname $0`
 
 rm -f *.err* *.log* *.lrat[12] *.cnf[12]
 rm -f add4trim[12].cnf add5.cnf add5.cnf
+rm -f add4compressed.*
 
 lrattrim=../../lrat-trim
 
@@ -26,7 +27,7 @@ run () {
   while [ $# -gt 0 ]
   do
     case $1 in
-      -*|/dev/null) pretty="$pretty $1"; cmd="$cmd $1";;
+      -*|/dev/null|/dev/stdin) pretty="$pretty $1"; cmd="$cmd $1";;
       *) pretty="$pretty test/usage/$1"; cmd="$cmd $1";;
     esac
     shift
@@ -54,6 +55,9 @@ run 0 options2 --help
 run 0 version1 -V
 run 0 version2 --version
 run 1 invalidoption --this-is-not-a-valid-option
+run 1 invalidthreads --threads=0 add4.lrat
+run 1 invalidmemory --memory=1x add4.lrat
+run 1 invalidframesize --framed=0 add4.lrat
 run 1 invalidinput this-is-no-a-file
 run 1 toomanyfiles a b c d e
 run 1 noinputfile
@@ -74,6 +78,18 @@ run 20 add4writeall -q add4.cnf add4.lrat add4.lrat1 add4.cnf1
 run 20 add4writeallagain1 -v add4.cnf add4.lrat1
 run 20 add8writeall -q add8.cnf add8.lrat add8.lrat1 add8.cnf1
 run 20 add8writeallagain1 -v add8.cnf add8.lrat1 --relax
+run 20 add8spilled -v add8.cnf add8.lrat add8spilled.lrat1 --memory=0
+run 20 add8lazy -v add8.cnf add8.lrat add8lazy.lrat1 add8lazy.cnf1 --lazy
+run 20 add8lazyspilled add8.cnf add8.lrat --lazy --memory=0
+run 20 add4lazynotrim add4.cnf add4.lrat --lazy --no-trim
+run 20 add4lazycompressed add4.cnf.gz add4.lrat --lazy
+run 0 sparse sparse.lrat
+memory=`sed -n 's/^c maximum memory usage of \([0-9]*\) MB$/\1/p' sparse.log`
+[ "$memory" -lt 100 ] || \
+die "trimming proof starting at identifier 1000000000 needed $memory MB"
+run 20 maxid maxid.cnf maxid.lrat maxid.lrat1
+$lrattrim -h | grep -q -- --threads && \
+run 20 maxidthreads maxid.cnf maxid.lrat --threads=4
 run 0 add4null1 add8.cnf /dev/null /dev/null /dev/null
 run 0 add4null2 add8.cnf /dev/null /dev/null add8.cnf2
 run 0 add4null3 add8.cnf /dev/null add8.lrat2 /dev/null
@@ -119,6 +135,14 @@ run 0 stdin - </dev/null
 run 0 twicenull /dev/null /dev/null
 run 0 noproofascii -a /dev/null
 bzip2 -d -c proofbomb.bz2 | run 0 fillbuffer -
+cat add4.lrat | run 20 pipe add4.cnf /dev/stdin
+gzip -c add4.lrat | run 1 compressedpipe add4.cnf /dev/stdin
+run 20 compressed1 add4.cnf.gz add4.lrat.bz2
+run 20 compressed2 add4.cnf.gz add4.lrat
+run 0 compressed3 add4.lrat.bz2 add4compressed.lrat1
+run 20 compressed4 add4.cnf add4.lrat add4compressed.lrat.gz add4compressed.cnf.gz
+run 20 compressed5 add4.cnf add4compressed.lrat.gz
+run 0 compressed6 add4compressed.cnf.gz /dev/null
 
 $lrattrim -l -h >/dev/null 2>/dev/null && \
 run 20 add4log add4.cnf add4.lrat -l